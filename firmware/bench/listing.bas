@@ -0,0 +1,8 @@
+10 REM paste benchmark listing
+20 FOR i=1 TO 10
+30 PRINT AT i,i;"HC2000 {[|]}";i*i
+40 IF i<>5 THEN GO SUB 100
+50 NEXT i
+60 STOP
+100 LET a$="~\": PRINT a$;" ";USR 0
+110 RETURN
@@ -0,0 +1,203 @@
+/*
+ * paste_host.c
+ *
+ * Created: 17/10/2026 6:03:45 PM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+/*
+ Paste benchmark; runs a firmware ELF built with PASTE under simavr.
+
+ A scripted host sends a byte stream made by tools/paste.py --output into UNUSED_IO (PD6) as
+ 8N1 serial and stops on XOFF from the UART, like a PC serial port with flow control; -l makes it
+ send that many more bytes after an XOFF, as a PC UART FIFO would. The MT8808 strobes are
+ followed to count the keys typed. It reports the typing rate, the flow control traffic and
+ whether the stream was typed to the end.
+
+ usage: paste_host [-m mcu] [-b baud] [-l lag_bytes] firmware.elf stream.bin
+ see "make bench-paste" in firmware/Makefile
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/sim_time.h>
+#include <simavr/sim_cycle_timers.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+
+#define PASTE_RX	6	//PD6
+#define MT_STROBE	6	//PB6
+#define MT_DATA		7	//PB7
+#define ADDR_MASK	0x3f
+
+#define XON			0x11
+#define XOFF		0x13
+
+#define BOOT_US		200000
+#define SETTLE_US	1000000	//typing is done once the switches have been quiet this long
+#define MAX_STREAM	65536
+
+static avr_t * avr;
+static avr_irq_t * rx_pin;
+static uint32_t bit_cycles;
+
+static uint8_t stream[MAX_STREAM];
+static uint32_t stream_len,stream_pos;
+
+//host transmitter
+static uint16_t tx_frame;
+static uint8_t tx_bit;
+static uint8_t tx_busy;
+static uint8_t stopped;
+static uint32_t lag,lag_left;
+static uint32_t xoffs,xons,after_xoff,max_after_xoff;
+
+//switch log
+static uint64_t closed;
+static uint32_t presses;
+static avr_cycle_count_t last_strobe;
+static uint8_t last_portb;
+
+static avr_cycle_count_t tx_cb(avr_t * avr, avr_cycle_count_t when, void * param){
+	if (tx_bit==0) {
+		//flow control is checked between bytes, a FIFO keeps going for lag bytes
+		if (stream_pos==stream_len) {
+			tx_busy=0;
+			return 0;
+		}
+		if (stopped) {
+			if (lag_left==0) return when+bit_cycles;
+			lag_left--;
+			after_xoff++;
+		}
+		tx_frame=(1<<9) | ((uint16_t)stream[stream_pos++]<<1);
+	}
+	avr_raise_irq(rx_pin,(tx_frame>>tx_bit) & 1);
+	if (++tx_bit==10) tx_bit=0;
+	return when+bit_cycles;
+}
+
+static void uart_cb(avr_irq_t * irq, uint32_t value, void * param){
+	if (value==XOFF) {
+		xoffs++;
+		stopped=1;
+		lag_left=lag;
+		after_xoff=0;
+	}
+	else if (value==XON) {
+		xons++;
+		stopped=0;
+		if (after_xoff>max_after_xoff) max_after_xoff=after_xoff;
+	}
+}
+
+static void portb_cb(avr_irq_t * irq, uint32_t value, void * param){
+	//the crosspoint latches when the strobe goes low again; a key is pressed when the first one closes
+	if ((last_portb & (1<<MT_STROBE)) && !(value & (1<<MT_STROBE))) {
+		uint64_t bit=1ULL<<(last_portb & ADDR_MASK);
+		if (last_portb & (1<<MT_DATA)) {
+			if (!closed) presses++;
+			closed|=bit;
+		}
+		else closed&=~bit;
+		last_strobe=avr->cycle;
+	}
+	last_portb=value;
+}
+
+static void run_for_usec(uint32_t us){
+	avr_cycle_count_t end=avr->cycle+avr_usec_to_cycles(avr,us);
+	while (avr->cycle<end) {
+		int state=avr_run(avr);
+		if ((state==cpu_Done) || (state==cpu_Crashed)) {
+			fprintf(stderr,"firmware stopped (state %d)\n",state);
+			exit(1);
+		}
+	}
+}
+
+int main(int argc, char * argv[]){
+	elf_firmware_t f={{0}};
+	const char * mcu=NULL;
+	uint32_t baud=9600;
+	uint32_t flags=0;
+	avr_cycle_count_t start;
+	FILE * in;
+	int opt=1;
+
+	for (; (opt<argc) && (argv[opt][0]=='-'); opt++) {
+		if (!strcmp(argv[opt],"-m") && (opt+1<argc)) mcu=argv[++opt];
+		else if (!strcmp(argv[opt],"-b") && (opt+1<argc)) baud=strtoul(argv[++opt],NULL,10);
+		else if (!strcmp(argv[opt],"-l") && (opt+1<argc)) lag=strtoul(argv[++opt],NULL,10);
+	}
+	if (opt+2!=argc) {
+		fprintf(stderr,"usage: %s [-m mcu] [-b baud] [-l lag_bytes] firmware.elf stream.bin\n",argv[0]);
+		return 2;
+	}
+	in=fopen(argv[opt+1],"rb");
+	if (!in) {
+		fprintf(stderr,"cannot read %s\n",argv[opt+1]);
+		return 1;
+	}
+	stream_len=fread(stream,1,sizeof(stream),in);
+	fclose(in);
+
+	if (elf_read_firmware(argv[opt],&f)) {
+		fprintf(stderr,"cannot read %s\n",argv[opt]);
+		return 1;
+	}
+	if (!mcu) mcu=f.mmcu[0] ? f.mmcu : "attiny4313";
+	if (!f.frequency) f.frequency=16000000;
+	avr=avr_make_mcu_by_name(mcu);
+	if (!avr) {
+		fprintf(stderr,"simavr does not know %s\n",mcu);
+		return 1;
+	}
+	avr_init(avr);
+	avr_load_firmware(avr,&f);
+	bit_cycles=f.frequency/baud;
+
+	rx_pin=avr_io_getirq(avr,AVR_IOCTL_IOPORT_GETIRQ('D'),PASTE_RX);
+	avr_irq_register_notify(avr_io_getirq(avr,AVR_IOCTL_IOPORT_GETIRQ('B'),IOPORT_IRQ_PIN_ALL),portb_cb,NULL);
+	avr_irq_register_notify(avr_io_getirq(avr,AVR_IOCTL_UART_GETIRQ('0'),UART_IRQ_OUTPUT),uart_cb,NULL);
+	//the flow control bytes are for the host, not the console
+	avr_ioctl(avr,AVR_IOCTL_UART_GET_FLAGS('0'),&flags);
+	flags&=~AVR_UART_FLAG_STDIO;
+	avr_ioctl(avr,AVR_IOCTL_UART_SET_FLAGS('0'),&flags);
+	avr_raise_irq(rx_pin,1);
+
+	printf("%s at %"PRIu32" Hz, %"PRIu32" baud, %"PRIu32" bytes, host lag %"PRIu32" bytes\n",mcu,f.frequency,baud,stream_len,lag);
+	run_for_usec(BOOT_US);
+	start=avr->cycle;
+	tx_busy=1;
+	avr_cycle_timer_register(avr,bit_cycles,tx_cb,NULL);
+	while (tx_busy || (avr_cycles_to_usec(avr,avr->cycle-last_strobe)<SETTLE_US)) run_for_usec(10000);
+
+	double seconds=avr_cycles_to_usec(avr,last_strobe-start)/1e6;
+	printf("sent %"PRIu32" of %"PRIu32" bytes, %"PRIu32" key presses in %.2f s, %.1f per second\n",
+		stream_pos,stream_len,presses,seconds,seconds>0 ? presses/seconds : 0);
+	printf("XOFF %"PRIu32" XON %"PRIu32", at most %"PRIu32" bytes sent after an XOFF\n",xoffs,xons,max_after_xoff);
+	if (closed) printf("crosspoints still closed: %016"PRIx64"\n",closed);
+	return (stream_pos==stream_len) && !closed ? 0 : 1;
+}
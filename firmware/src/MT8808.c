@@ -25,32 +25,118 @@
 
 #include <inttypes.h>
 #include <MT8808.h>
-#include <util/delay.h>
+#include <hal.h>
 #include <pins.h>
+#include <telemetry.h>
 
-#define MT8808_DELAY 3
+//switch actions waiting for the timer; each one runs delay ms after the previous one
+//head is only written by MT8808_queue(), tail only by MT8808_tick()
+static uint8_t mt_queue_action[MT8808_QUEUE_SIZE];
+static uint8_t mt_queue_delay[MT8808_QUEUE_SIZE];
+volatile static uint8_t mt_queue_head,mt_queue_tail;
+
+//shadow of the matrix: a 4 bit count per crosspoint of the keys currently holding it closed
+static uint8_t mt_refs[MT8808_CROSSPOINTS/2];
 
 void MT8808_reset(void){
-	//start strobe
-	PORTB |= 1 << MT_STROBE;
-	PORTD |=1 << MT_RESET;
-	_delay_us(MT8808_DELAY);
-	PORTD &=~(1 << MT_RESET);
-	//end strobe
-	PORTB &=~(1 << MT_STROBE);	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		//pending actions would close switches again
+		mt_queue_tail=mt_queue_head;
+		for (uint8_t i=0; i<sizeof(mt_refs); i++) mt_refs[i]=0;
+		//start strobe
+		PORTB |= 1 << MT_STROBE;
+		PORTD |=1 << MT_RESET;
+		hal_delay_ns(MT8808_T_RPW);
+		PORTD &=~(1 << MT_RESET);
+		//end strobe
+		PORTB &=~(1 << MT_STROBE);	
+	}
+	telemetry_event(TELEMETRY_RESET,0);
 }
 
 
-void MT8808_switch(uint8_t addr, uint8_t state){		
-	//set address
-	PORTB =(PORTB & (~ADDR_MASK)) | (addr & ADDR_MASK);
-	_delay_us(MT8808_DELAY); //tAS
+//port B only drives the MT8808, so each step is a single write of the whole port
+//an action is the address and the data bit, MT8808_ACTION_ON is already MT_DATA
+static void MT8808_write(uint8_t action){
+	//address and data
+	PORTB=action;
+	hal_delay_ns(MT8808_T_AS);
 	//start strobe
-	PORTB |= 1 << MT_STROBE;
-	//set data	
-	if (state) PORTB |=1 << MT_DATA;	//set data
-	else PORTB &=~(1 << MT_DATA);		//reset data
-	_delay_us(MT8808_DELAY);
+	PORTB=action | (1 << MT_STROBE);
+	hal_delay_ns(MT8808_T_SPW);
 	//end strobe	
-	PORTB &=~(1 << MT_STROBE);
+	PORTB=action;
+	hal_delay_ns(MT8808_T_AH);
+	telemetry_event(TELEMETRY_SWITCH,action);
+}
+
+
+void MT8808_switch(uint8_t addr, uint8_t state){		
+	MT8808_write((addr & ADDR_MASK) | (state ? MT8808_ACTION_ON : 0));
+}
+
+
+//a crosspoint closes for its first user and opens after its last one; the bus is not touched otherwise
+static void MT8808_ref(uint8_t action){
+	uint8_t addr=action & ADDR_MASK;
+	if (addr>=MT8808_CROSSPOINTS) return;
+	uint8_t shift=(addr & 1) ? 4 : 0;
+	uint8_t count=(mt_refs[addr>>1]>>shift) & 0x0f;
+	if (action & MT8808_ACTION_ON) {
+		if (count==0x0f) return;//saturated
+		if (count++==0) MT8808_write(action);
+	}
+	else {
+		if (count==0) return;//already open, e.g. a break without its make
+		if (--count==0) MT8808_write(action);
+	}
+	mt_refs[addr>>1]=(mt_refs[addr>>1] & ~(0x0f<<shift)) | (count<<shift);
+}
+
+
+//actions MT8808_queue_list() takes without waiting; the decoders check it before a whole key sequence
+uint8_t MT8808_queue_free(void){
+	return (mt_queue_tail-mt_queue_head-1) & (MT8808_QUEUE_SIZE-1);
+}
+
+
+//schedules switch actions that go out back to back, delay_ms after the ones already queued
+//with no delay and nothing pending they are switched right away
+//the callers check MT8808_queue_free() before a whole sequence; a list that does not fit is dropped,
+//waiting here for the timer would never end with interrupts off
+void MT8808_queue_list(const uint8_t * actions, uint8_t count, uint8_t delay_ms){
+	if (MT8808_queue_free()<count) return;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		if ((delay_ms==0) && (mt_queue_head==mt_queue_tail)) {
+			for (uint8_t i=0; i<count; i++) MT8808_ref(actions[i]);
+		}
+		else {
+			for (uint8_t i=0; i<count; i++) {
+				mt_queue_action[mt_queue_head]=actions[i];
+				mt_queue_delay[mt_queue_head]=delay_ms;
+				mt_queue_head=(mt_queue_head+1) & (MT8808_QUEUE_SIZE-1);
+				delay_ms=0;
+			}
+		}
+	}
+}
+
+
+void MT8808_queue(uint8_t addr, uint8_t state, uint8_t delay_ms){
+	uint8_t action=addr & ADDR_MASK;
+	if (state) action|=MT8808_ACTION_ON;
+	MT8808_queue_list(&action,1,delay_ms);
+}
+
+
+//plays the due actions; called every ms from the timer interrupt
+void MT8808_tick(void){
+	while (mt_queue_tail!=mt_queue_head) {
+		if (mt_queue_delay[mt_queue_tail]>1) {
+			mt_queue_delay[mt_queue_tail]--;
+			break;
+		}
+		MT8808_ref(mt_queue_action[mt_queue_tail]);
+		mt_queue_tail=(mt_queue_tail+1) & (MT8808_QUEUE_SIZE-1);
+	}
 }
@@ -25,16 +25,27 @@
 #ifndef MT8808_H_
 #define MT8808_H_
 
-#ifndef F_CPU
-#define F_CPU 16000000UL
-#endif
-
-
+#include <hal.h> //F_CPU
+#include <config.h> //MT8808_QUEUE_SIZE
 #include <inttypes.h>
 
 #define ADDR_MASK 0x3f //data,strobe,AY2,AY1,AY0,AX2,AX1,AX0
 
+#define MT8808_CROSSPOINTS 40 //8 rows x 5 columns of the ZX matrix, addresses 0..39
+
+#define MT8808_ACTION_ON 0x80 //state bit of a switch action, the rest is the address
+
+//datasheet minimums in ns, turned into CPU cycles for the F_CPU the firmware is built for
+#define MT8808_T_AS		10	//address and data setup before the strobe
+#define MT8808_T_SPW	20	//strobe pulse width
+#define MT8808_T_AH		10	//address and data hold after the strobe
+#define MT8808_T_RPW	40	//reset pulse width
+
 void MT8808_reset(void);
 void MT8808_switch(uint8_t addr, uint8_t state);
+void MT8808_queue(uint8_t addr, uint8_t state, uint8_t delay_ms);
+void MT8808_queue_list(const uint8_t * actions, uint8_t count, uint8_t delay_ms);
+uint8_t MT8808_queue_free(void);
+void MT8808_tick(void);
 
 #endif /* MT8808_H_ */
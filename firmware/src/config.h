@@ -0,0 +1,93 @@
+/*
+ * config.h
+ *
+ * Created: 17/10/2026 3:26:40 PM
+ *  Author: sphome
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+//buffer sizes for each MCU; "make footprint" checks that data and the deepest stack fit the RAM
+
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+#if defined(__AVR_ATtiny2313__) || defined(__AVR_ATtiny2313A__)
+
+//128 bytes of RAM for everything, stack included
+#define PS2_BUF_SIZE		8	//received bytes waiting for poll_kb(), also the keys typed during a macro
+#define MT8808_QUEUE_SIZE	16	//switch actions waiting for the timer; the decoders wait for room before each key
+#define KB_HELD_KEYS		3	//keys down at the same time before the oldest is released
+#define TELEMETRY_BUF_SIZE	16	//bytes of event records waiting for the software UART
+#define PASTE_BUF_SIZE		16	//pasted bytes waiting to be typed
+#define MOUSE_BUF_SIZE		4	//bytes from the mouse waiting for poll_mouse(), one packet is 3
+#define MACRO_SLOT_SIZE		40	//EEPROM bytes of each recorded macro, 2 of them header; ps2_kb.c checks that the slots, the built in macros and the keymap profile fit
+
+#else
+
+//256 bytes of RAM for everything, stack included
+#define PS2_BUF_SIZE		16
+#define MT8808_QUEUE_SIZE	16
+#define KB_HELD_KEYS		4
+#define TELEMETRY_BUF_SIZE	32
+#define PASTE_BUF_SIZE		32
+#define MOUSE_BUF_SIZE		8
+#define MACRO_SLOT_SIZE		100
+
+#endif
+
+//the features below that are off by default do not fit the flash all together, "make footprint" checks a choice of them
+
+//PS/2 mouse on MOUSE_CLK/MOUSE_DATA as cursor keys, see mouse.h
+//#define PS2_MOUSE
+
+//typematic rate and LEDs sent to the keyboard, see config_kb(); off, the keyboard keeps its power up settings
+//scan code set 3 is selected by a command, it needs them
+#define KB_COMMANDS
+
+//the status LED flashes the scan code of each key pressed, see led.h; off, it only lights up at power up
+#define LED_BLINK
+
+//a second keymap for CP/M, Scroll Lock switches to it and back, see PS2_CPM_KEYS
+//#define KB_CPM_PROFILE
+
+//macros recorded at run time into EEPROM with F12, played with F3 and F4
+//#define MACRO_RECORD
+#define MACRO_SLOTS			2	//recorded macros
+
+//event records out of UNUSED_IO, see telemetry.h; off by default, it costs flash, RAM and timer 0
+//#define TELEMETRY
+#define TELEMETRY_BAUD		38400	//timer 0 rounds the bit time to a whole number of clk/8 counts
+
+//text typed from a serial port on UNUSED_IO, see paste.h; off by default, it costs flash, RAM and the UART
+//#define PASTE
+#define PASTE_BAUD			9600	//timer 1 rounds the bit time to a whole number of clk/64 counts
+
+#if defined(TELEMETRY) && defined(PASTE)
+#error "TELEMETRY and PASTE both use UNUSED_IO"
+#endif
+
+//the ring buffer indexes wrap with a mask
+_Static_assert((PS2_BUF_SIZE & (PS2_BUF_SIZE-1))==0,"PS2_BUF_SIZE must be a power of 2");
+_Static_assert((MT8808_QUEUE_SIZE & (MT8808_QUEUE_SIZE-1))==0,"MT8808_QUEUE_SIZE must be a power of 2");
+_Static_assert((TELEMETRY_BUF_SIZE & (TELEMETRY_BUF_SIZE-1))==0,"TELEMETRY_BUF_SIZE must be a power of 2");
+_Static_assert((PASTE_BUF_SIZE & (PASTE_BUF_SIZE-1))==0,"PASTE_BUF_SIZE must be a power of 2");
+_Static_assert((MOUSE_BUF_SIZE & (MOUSE_BUF_SIZE-1))==0,"MOUSE_BUF_SIZE must be a power of 2");
+//a shifted key, e.g. CAPS+key, needs two held keys
+_Static_assert(KB_HELD_KEYS>=2,"KB_HELD_KEYS must be at least 2");
+
+#endif /* CONFIG_H_ */
@@ -0,0 +1,55 @@
+/*
+ * hal.h
+ *
+ * Created: 17/10/2026 11:40:05 AM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+//the only place that includes avr-libc; a host build gets the recording backend of hal_host.c instead
+
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+//smallest number of CPU cycles that lasts at least ns
+#define HAL_NS_TO_CYCLES(ns)	(((ns)*(F_CPU/1000000UL)+999)/1000)
+
+#ifdef __AVR__
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/eeprom.h>
+#include <avr/sleep.h>
+#include <util/delay.h>
+#include <util/atomic.h>
+
+#define hal_delay_ns(ns)	__builtin_avr_delay_cycles(HAL_NS_TO_CYCLES(ns))
+
+#else
+
+#include <hal_host.h>
+
+#endif
+
+#endif /* HAL_H_ */
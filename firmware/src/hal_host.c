@@ -0,0 +1,300 @@
+/*
+ * hal_host.c
+ *
+ * Created: 17/10/2026 11:58:20 AM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+//host backend of hal.h; replaces the ports, the delays and the timer with a simulated clock
+//and reports every MT8808 strobe through hal_host_switch_hook, see "make host" in firmware/Makefile
+
+#ifndef __AVR__
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <hal.h>
+#include <pins.h>
+#include <MT8808.h>
+#include <timer.h>
+#include <config.h>
+
+#define HAL_HOST_PS2_HALF_BIT_US 40 //12.5 kHz keyboard clock
+#define HAL_HOST_SERIAL_BIT_US (1000000UL/PASTE_BAUD)
+
+volatile uint8_t PORTB, DDRB, PINB;
+volatile uint8_t PORTD, DDRD, PIND=0xff;
+volatile uint8_t MCUCR, GIMSK, EIFR, TIMSK, TIFR;
+volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A;
+volatile uint8_t TCCR1A, TCCR1B;
+volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+volatile uint8_t UBRRH, UBRRL, UCSRA=1<<UDRE, UCSRB, UDR;
+
+uint32_t hal_host_time_us;
+uint32_t hal_host_switch_count;
+uint32_t hal_host_reset_count;
+hal_host_switch_hook_t hal_host_switch_hook=NULL;
+hal_host_ps2_rx_hook_t hal_host_ps2_rx_hook=NULL;
+hal_host_tx_hook_t hal_host_tx_hook=NULL; //TELEMETRY_TX level after every timer 0 compare, one call per bit
+hal_host_uart_hook_t hal_host_uart_hook=NULL; //every byte written to UDR, it is sent at once
+uint8_t hal_host_ps2_reply=0xFA; //what the keyboard answers to every byte it receives, 0 for no keyboard
+
+static uint8_t hal_host_in_isr;
+//host to keyboard frame in progress, counted in clock half periods
+static uint8_t hal_host_rx_step;
+static uint32_t hal_host_rx_next;
+static uint16_t hal_host_rx_frame;
+static uint8_t hal_host_rx_answer;
+//timer 0 compare, in CPU cycles; the weak handler stands in when telemetry is not built
+static uint64_t hal_host_t0_due;
+static uint8_t hal_host_t0_on;
+//timer 1 compares that came while a handler ran
+static uint8_t hal_host_t1_pending;
+
+void __attribute__((weak)) TIMER0_COMPA_vect(void){
+}
+
+void __attribute__((weak)) TIMER1_COMPB_vect(void){
+}
+
+void __attribute__((weak)) TIMER1_CAPT_vect(void){
+}
+
+void __attribute__((weak)) INT1_vect(void){
+}
+
+void __attribute__((weak)) USART_UDRE_vect(void){
+}
+
+
+static void hal_host_isr(void (*vector)(void)){
+	hal_host_in_isr=1;
+	vector();
+	hal_host_in_isr=0;
+	if (UDR && (UCSRB & (1<<TXEN))) {
+		if (hal_host_uart_hook) hal_host_uart_hook(hal_host_time_us,UDR);
+		UDR=0;
+	}
+	//the data register is always empty here, a byte written goes out at once
+	if (UCSRB & (1<<UDRIE)) hal_host_isr(USART_UDRE_vect);
+	//compares the handler ran past are served after it, as their flags would be
+	if (hal_host_t1_pending & (1<<OCF1A)) {
+		hal_host_t1_pending&=~(1<<OCF1A);
+		if (TIMSK & (1<<OCIE1A)) hal_host_isr(TIMER1_COMPA_vect);
+	}
+	if (hal_host_t1_pending & (1<<OCF1B)) {
+		hal_host_t1_pending&=~(1<<OCF1B);
+		if (TIMSK & (1<<OCIE1B)) hal_host_isr(TIMER1_COMPB_vect);
+	}
+}
+
+
+//moves the simulated clock to time_us and fires the timer 1 compare interrupts on the way, the earlier first
+static void hal_host_timer1_until(uint32_t time_us){
+	if (time_us>hal_host_time_us) hal_host_time_us=time_us;
+	for (;;) {
+		//the interrupt may have moved the clock further, so recompute every time
+		uint16_t count=(uint16_t)((uint64_t)hal_host_time_us*(F_CPU/TIMER_PRESCALER)/1000000UL);
+		if (TCNT1==count) break;
+		uint16_t span=count-TCNT1;
+		uint16_t to_a=OCR1A-TCNT1;
+		uint16_t to_b=OCR1B-TCNT1;
+		uint8_t a=(to_a>0) && (to_a<=span) && (TIMSK & (1<<OCIE1A));
+		uint8_t b=(to_b>0) && (to_b<=span) && (TIMSK & (1<<OCIE1B));
+		if (hal_host_in_isr) {
+			if (a) hal_host_t1_pending|=1<<OCF1A;
+			if (b) hal_host_t1_pending|=1<<OCF1B;
+			TCNT1=count;
+		}
+		else if (a && (!b || (to_a<=to_b))) {
+			TCNT1=OCR1A;
+			if (b && (to_b==to_a)) hal_host_t1_pending|=1<<OCF1B;
+			hal_host_isr(TIMER1_COMPA_vect);
+		}
+		else if (b) {
+			TCNT1=OCR1B;
+			hal_host_isr(TIMER1_COMPB_vect);
+		}
+		else TCNT1=count;
+	}
+}
+
+
+//calls the INT0 handler when the edge matches ISC01:ISC00
+static void hal_host_int0_edge(uint8_t rising){
+	uint8_t sense=MCUCR & ((1<<ISC01) | (1<<ISC00));
+	if (!(GIMSK & (1<<INT0))) return;
+	if ((sense==(1<<ISC01)) && !rising) INT0_vect();
+	else if ((sense==((1<<ISC01) | (1<<ISC00))) && rising) INT0_vect();
+}
+
+
+static void hal_host_ps2_receive(void);
+
+//moves the simulated clock; timer 0 in CTC mode at clk/8 fires its compare interrupt every OCR0A+1 counts
+static void hal_host_advance(uint32_t us){
+	uint32_t end=hal_host_time_us+us;
+	for (;;) {
+		uint8_t on=(TIMSK & (1<<OCIE0A)) && (TCCR0B & (1<<CS01));
+		uint64_t now=(uint64_t)hal_host_time_us*(F_CPU/1000000UL);
+		if (on && !hal_host_t0_on) hal_host_t0_due=now+8*(OCR0A+1);
+		hal_host_t0_on=on;
+		uint32_t due_us=(uint32_t)(hal_host_t0_due/(F_CPU/1000000UL));
+		if (!on || hal_host_in_isr || (due_us>end)) break;
+		hal_host_timer1_until(due_us);
+		hal_host_t0_due+=8*(OCR0A+1);
+		hal_host_isr(TIMER0_COMPA_vect);
+		if (hal_host_tx_hook) hal_host_tx_hook(hal_host_time_us,(PORTD>>TELEMETRY_TX) & 1);
+	}
+	hal_host_timer1_until(end);
+	if ((UCSRB & (1<<UDRIE)) && !hal_host_in_isr) hal_host_isr(USART_UDRE_vect);
+}
+
+
+//the same, with a frame to the keyboard clocked at the pace of the keyboard on the way
+void hal_host_advance_us(uint32_t us){
+	uint32_t end=hal_host_time_us+us;
+	hal_host_ps2_receive();
+	while (hal_host_rx_step && (hal_host_rx_next<=end)) {
+		if (hal_host_rx_next>hal_host_time_us) hal_host_advance(hal_host_rx_next-hal_host_time_us);
+		hal_host_ps2_receive();
+	}
+	if (end>hal_host_time_us) hal_host_advance(end-hal_host_time_us);
+}
+
+
+//the keyboard side of a host to keyboard frame; it clocks in 8 data bits, parity and stop, then acknowledges
+//its clock edges reach the INT0 handler when the firmware has it on, as they would on the chip
+static void hal_host_ps2_receive(void){
+	uint8_t host_clk_low=(DDRD & (1<<KBD_CLK)) && !(PORTD & (1<<KBD_CLK));
+	uint8_t host_data_low=(DDRD & (1<<KBD_DATA)) && !(PORTD & (1<<KBD_DATA));
+	if (!hal_host_ps2_reply) return;
+	if (!hal_host_rx_step) {
+		//request to send: data pulled low and the clock let go
+		if (host_data_low && !host_clk_low) {
+			hal_host_rx_step=1;
+			hal_host_rx_next=hal_host_time_us+HAL_HOST_PS2_HALF_BIT_US;
+			hal_host_rx_frame=0;
+		}
+		//answer once the host listens again
+		else if (hal_host_rx_answer && !host_clk_low && (GIMSK & (1<<INT0))) {
+			uint8_t answer=hal_host_rx_answer;
+			hal_host_rx_answer=0;
+			hal_host_ps2_send(answer);
+		}
+		return;
+	}
+	if (hal_host_time_us<hal_host_rx_next) return;
+	hal_host_rx_next+=HAL_HOST_PS2_HALF_BIT_US;
+	uint8_t bit=(hal_host_rx_step-1)/2;
+	if (hal_host_rx_step & 1) {
+		if (bit==10) PIND&=~(1<<KBD_DATA);//acknowledge
+		PIND&=~(1<<KBD_CLK);
+		hal_host_int0_edge(0);
+	}
+	else {
+		PIND|=1<<KBD_CLK;
+		hal_host_int0_edge(1);
+		if (bit<10) {
+			if (!host_data_low) hal_host_rx_frame|=1<<bit;
+		}
+		else {
+			PIND|=1<<KBD_DATA;
+			hal_host_rx_step=0;
+			uint8_t byte=(uint8_t)hal_host_rx_frame;
+			uint8_t good=__builtin_parity(hal_host_rx_frame & 0x1ff) && (hal_host_rx_frame & (1<<9));
+			if (good && hal_host_ps2_rx_hook) hal_host_ps2_rx_hook(hal_host_time_us,byte);
+			hal_host_rx_answer=good ? hal_host_ps2_reply : 0xFE;
+			return;
+		}
+	}
+	hal_host_rx_step++;
+}
+
+
+//the strobe and reset pulses are held for a delay, which is where they get recorded
+void hal_host_delay_us(uint32_t us){
+	hal_host_ps2_receive();
+	if (PORTD & (1<<MT_RESET)) hal_host_reset_count++;
+	else if (PORTB & (1<<MT_STROBE)) {
+		hal_host_switch_count++;
+		if (hal_host_switch_hook) hal_host_switch_hook(hal_host_time_us,PORTB & ADDR_MASK,(PORTB>>MT_DATA) & 1);
+	}
+	hal_host_advance_us(us);
+}
+
+
+//calls the INT1 handler when the edge matches ISC11:ISC10
+static void hal_host_int1_edge(uint8_t rising){
+	uint8_t sense=MCUCR & ((1<<ISC11) | (1<<ISC10));
+	if (!(GIMSK & (1<<INT1))) return;
+	if ((sense==(1<<ISC11)) && !rising) INT1_vect();
+	else if ((sense==((1<<ISC11) | (1<<ISC10))) && rising) INT1_vect();
+}
+
+
+//clocks one device-to-host frame on the clk and data pins of PIND
+static void hal_host_frame_send(uint8_t clk, uint8_t data, void (*edge)(uint8_t rising), uint8_t byte){
+	uint16_t frame=(1<<10) | ((uint16_t)byte<<1);//stop, data, start
+	if (!__builtin_parity(byte)) frame|=1<<9;//odd parity
+	for (uint8_t i=0; i<11; i++) {
+		if (frame & (1<<i)) PIND|=1<<data;
+		else PIND&=~(1<<data);
+		hal_host_advance_us(HAL_HOST_PS2_HALF_BIT_US);
+		PIND&=~(1<<clk);
+		edge(0);
+		hal_host_advance_us(HAL_HOST_PS2_HALF_BIT_US);
+		PIND|=1<<clk;
+		edge(1);
+	}
+	PIND|=1<<data;
+}
+
+
+//clocks one device-to-host frame into the INT0 handler
+//the keyboard first takes in the frame the firmware is sending it and answers that
+void hal_host_ps2_send(uint8_t byte){
+	hal_host_ps2_receive();
+	while (hal_host_rx_step || hal_host_rx_answer) hal_host_advance_us(HAL_HOST_PS2_HALF_BIT_US);
+	hal_host_frame_send(KBD_CLK,KBD_DATA,hal_host_int0_edge,byte);
+}
+
+
+//the same from the mouse, into the INT1 handler; commands sent to the mouse are not answered
+void hal_host_mouse_send(uint8_t byte){
+	hal_host_frame_send(MOUSE_CLK,MOUSE_DATA,hal_host_int1_edge,byte);
+}
+
+
+//one 8N1 frame into UNUSED_IO, the input capture interrupt sees the start bit
+void hal_host_serial_send(uint8_t byte){
+	uint16_t frame=(1<<9) | ((uint16_t)byte<<1);//stop, data, start
+	for (uint8_t i=0; i<10; i++) {
+		if (frame & (1<<i)) PIND|=1<<UNUSED_IO;
+		else {
+			if ((PIND & (1<<UNUSED_IO)) && (TIMSK & (1<<ICIE1)) && !hal_host_in_isr) {
+				ICR1=TCNT1;
+				hal_host_isr(TIMER1_CAPT_vect);
+			}
+			PIND&=~(1<<UNUSED_IO);
+		}
+		hal_host_advance_us(HAL_HOST_SERIAL_BIT_US);
+	}
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * hal_host.h
+ *
+ * Created: 17/10/2026 11:41:32 AM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+//stand-ins for the avr-libc pieces used by the firmware, see hal_host.c
+
+
+#ifndef HAL_HOST_H_
+#define HAL_HOST_H_
+
+#include <inttypes.h>
+
+//I/O registers are plain variables
+extern volatile uint8_t PORTB, DDRB, PINB;
+extern volatile uint8_t PORTD, DDRD, PIND;
+extern volatile uint8_t MCUCR, GIMSK, EIFR, TIMSK, TIFR;
+extern volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A;
+extern volatile uint8_t TCCR1A, TCCR1B;
+extern volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1;
+extern volatile uint8_t UBRRH, UBRRL, UCSRA, UCSRB, UDR;
+
+//bit positions as in the ATtiny2313/4313 datasheet
+#define PB0		0
+#define PB1		1
+#define PB2		2
+#define PB3		3
+#define PB4		4
+#define PB5		5
+#define PB6		6
+#define PB7		7
+
+#define PD0		0
+#define PD1		1
+#define PD2		2
+#define PD3		3
+#define PD4		4
+#define PD5		5
+#define PD6		6
+
+#define ISC00	0
+#define ISC01	1
+#define ISC10	2
+#define ISC11	3
+#define INT0	6
+#define INT1	7
+#define INTF0	6
+#define INTF1	7
+#define WGM01	1
+#define CS01	1
+#define OCIE0A	0
+#define OCF0A	0
+#define CS10	0
+#define CS11	1
+#define CS12	2
+#define OCIE1A	6
+#define OCF1A	6
+#define OCIE1B	5
+#define OCF1B	5
+#define ICIE1	3
+#define ICF1	3
+#define ICNC1	7
+#define TXEN	3
+#define UDRIE	5
+#define UDRE	5
+
+//interrupts are called directly by the host
+#define ISR(vector,...)	void vector(void); void vector(void)
+#define cli()
+#define sei()
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_BLOCK(type)	for (uint8_t hal_atomic=1; hal_atomic; hal_atomic=0)
+
+//sleeping returns at once, the host drives the interrupts itself
+#define SLEEP_MODE_IDLE		0
+#define set_sleep_mode(mode)
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_cpu()
+
+//flash and EEPROM are ordinary memory
+#define PROGMEM
+#define EEMEM
+#define PGM_P const char *
+#define pgm_read_byte(addr)		(*(const uint8_t *)(addr))
+#define pgm_read_word(addr)		(*(const uint16_t *)(addr))
+#define eeprom_read_byte(addr)	(*(const uint8_t *)(addr))
+#define eeprom_update_byte(addr,value)	(*(uint8_t *)(addr)=(value))
+#define E2END	0xFF	//the last EEPROM address of the ATtiny4313
+
+//delays advance the simulated clock
+#define _delay_us(us)	hal_host_delay_us(us)
+#define _delay_ms(ms)	hal_host_delay_us((ms)*1000UL)
+#define hal_delay_ns(ns)	hal_host_delay_us((ns)/1000UL)
+
+void INT0_vect(void);
+void TIMER1_COMPA_vect(void);
+void TIMER0_COMPA_vect(void);
+void TIMER1_COMPB_vect(void);
+void TIMER1_CAPT_vect(void);
+void INT1_vect(void);
+void USART_UDRE_vect(void);
+
+//recording backend
+typedef void (*hal_host_switch_hook_t)(uint32_t time_us, uint8_t addr, uint8_t state);
+typedef void (*hal_host_ps2_rx_hook_t)(uint32_t time_us, uint8_t byte);
+typedef void (*hal_host_tx_hook_t)(uint32_t time_us, uint8_t level);
+typedef void (*hal_host_uart_hook_t)(uint32_t time_us, uint8_t byte);
+
+extern uint32_t hal_host_time_us;
+extern uint32_t hal_host_switch_count;
+extern uint32_t hal_host_reset_count;
+extern hal_host_switch_hook_t hal_host_switch_hook;
+extern hal_host_ps2_rx_hook_t hal_host_ps2_rx_hook;
+extern hal_host_tx_hook_t hal_host_tx_hook;
+extern hal_host_uart_hook_t hal_host_uart_hook;
+extern uint8_t hal_host_ps2_reply;
+
+void hal_host_delay_us(uint32_t us);
+void hal_host_advance_us(uint32_t us);
+void hal_host_ps2_send(uint8_t byte);
+void hal_host_mouse_send(uint8_t byte);
+void hal_host_serial_send(uint8_t byte);
+
+#endif /* HAL_HOST_H_ */
@@ -0,0 +1,112 @@
+/*
+ * keymap.h
+ *
+ * Created: 17/10/2026 2:41:07 PM
+ *  Author: sphome
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+ */ 
+
+//the PS/2 keys that type something on the HC2000, with their scan code set 2 and set 3 make codes
+//no include guard: scan_code_lookup.h includes it once per table, with KEY, SHIFTED, CTRL and EXT defined to pick the entries
+//keys that are not listed give 0x00, no key
+//each key has a ZX key per layer: alone, with right shift or a SYM key held (the symbol above it, as on
+//a PC keyboard), and with Ctrl held; Ctrl already holds CAPS and SYM, so that layer has the bare key
+//KEY types the same on every layer, SHIFTED has a symbol above it and Ctrl types the bare key, CTRL lists all three
+//the extended keys type the same whatever is held
+
+//		set 2	set 3	ZX key							shifted						Ctrl
+CTRL(	0x0D,	0x0D,	ZX_KEY_TAB,						ZX_KEY_TAB,					ZX_KEY_P)		//tab
+CTRL(	0x0E,	0x0E,	ZX_KEY_TILDE,					ZX_KEY_TILDE,				ZX_KEY_A)		//` (back tick); no back tick in Spectrum; tilde with no shift
+KEY(	0x11,	0x19,	ZX_KEY_SYM)			//left alt
+KEY(	0x12,	0x12,	ZX_KEY_CAPS)		//left shift
+KEY(	0x14,	0x11,	ZX_KEY_CTRL)		//left control, E mode then CAPS+SYM held
+KEY(	0x15,	0x15,	ZX_KEY_Q)			//Q
+SHIFTED(0x16,	0x16,	ZX_KEY_1,						ZX_KEY_EXCL)								//1
+KEY(	0x1A,	0x1A,	ZX_KEY_Z)			//Z
+KEY(	0x1B,	0x1B,	ZX_KEY_S)			//S
+KEY(	0x1C,	0x1C,	ZX_KEY_A)			//A
+KEY(	0x1D,	0x1D,	ZX_KEY_W)			//W
+SHIFTED(0x1E,	0x1E,	ZX_KEY_2,						ZX_KEY_AT)									//2
+KEY(	0x21,	0x21,	ZX_KEY_C)			//C
+KEY(	0x22,	0x22,	ZX_KEY_X)			//X
+KEY(	0x23,	0x23,	ZX_KEY_D)			//D
+KEY(	0x24,	0x24,	ZX_KEY_E)			//E
+SHIFTED(0x25,	0x25,	ZX_KEY_4,						ZX_KEY_DOLLAR)								//4
+SHIFTED(0x26,	0x26,	ZX_KEY_3,						ZX_KEY_HASH)								//3
+KEY(	0x29,	0x29,	ZX_KEY_SP)			//space
+KEY(	0x2A,	0x2A,	ZX_KEY_V)			//V
+KEY(	0x2B,	0x2B,	ZX_KEY_F)			//F
+KEY(	0x2C,	0x2C,	ZX_KEY_T)			//T
+KEY(	0x2D,	0x2D,	ZX_KEY_R)			//R
+SHIFTED(0x2E,	0x2E,	ZX_KEY_5,						ZX_KEY_PERCENT)								//5
+KEY(	0x31,	0x31,	ZX_KEY_N)			//N
+KEY(	0x32,	0x32,	ZX_KEY_B)			//B
+KEY(	0x33,	0x33,	ZX_KEY_H)			//H
+KEY(	0x34,	0x34,	ZX_KEY_G)			//G
+KEY(	0x35,	0x35,	ZX_KEY_Y)			//Y
+SHIFTED(0x36,	0x36,	ZX_KEY_6,						ZX_KEY_HAT)									//6
+KEY(	0x3A,	0x3A,	ZX_KEY_M)			//M
+KEY(	0x3B,	0x3B,	ZX_KEY_J)			//J
+KEY(	0x3C,	0x3C,	ZX_KEY_U)			//U
+SHIFTED(0x3D,	0x3D,	ZX_KEY_7,						ZX_KEY_AMPER)								//7
+SHIFTED(0x3E,	0x3E,	ZX_KEY_8,						ZX_KEY_STAR)								//8
+CTRL(	0x41,	0x41,	ZX_KEY_COMMA,					ZX_KEY_ANG_BRACKET_OPEN,	ZX_KEY_N)		//comma ,
+KEY(	0x42,	0x42,	ZX_KEY_K)			//K
+KEY(	0x43,	0x43,	ZX_KEY_I)			//I
+KEY(	0x44,	0x44,	ZX_KEY_O)			//O
+SHIFTED(0x45,	0x45,	ZX_KEY_0,						ZX_KEY_ROUND_BRACKET_CLOSE)					//0 (zero)
+SHIFTED(0x46,	0x46,	ZX_KEY_9,						ZX_KEY_ROUND_BRACKET_OPEN)					//9
+CTRL(	0x49,	0x49,	ZX_KEY_PERIOD,					ZX_KEY_ANG_BRACKET_CLOSE,	ZX_KEY_M)		//.
+CTRL(	0x4A,	0x4A,	ZX_KEY_SLASH,					ZX_KEY_QMARK,				ZX_KEY_V)		///
+KEY(	0x4B,	0x4B,	ZX_KEY_L)			//L
+CTRL(	0x4C,	0x4C,	ZX_KEY_SEMICOLON,				ZX_KEY_COLON,				ZX_KEY_O)		//;
+KEY(	0x4D,	0x4D,	ZX_KEY_P)			//P
+CTRL(	0x4E,	0x4E,	ZX_KEY_MINUS,					ZX_KEY_UNDERSCORE,			ZX_KEY_J)		//-
+CTRL(	0x52,	0x52,	ZX_KEY_SINGLE_QUOTE,			ZX_KEY_DOUBLE_QUOTE,		ZX_KEY_7)		//'
+CTRL(	0x54,	0x54,	ZX_KEY_SQ_BRACKET_OPEN,			ZX_KEY_CURL_BRACKET_OPEN,	ZX_KEY_Y)		//[
+CTRL(	0x55,	0x55,	ZX_KEY_EQUAL,					ZX_KEY_PLUS,				ZX_KEY_L)		//=
+CTRL(	0x58,	0x14,	ZX_KEY_CAPS_LCK,				ZX_KEY_CAPS_LCK,			ZX_KEY_2)		//CapsLock
+KEY(	0x5A,	0x5A,	ZX_KEY_CR)			//enter
+CTRL(	0x5B,	0x5B,	ZX_KEY_SQ_BRACKET_CLOSE,		ZX_KEY_CURL_BRACKET_CLOSE,	ZX_KEY_U)		//]
+CTRL(	0x5D,	0x5C,	ZX_KEY_BACKSLASH,				ZX_KEY_PIPE,				ZX_KEY_D)		//backslash
+CTRL(	0x66,	0x66,	ZX_KEY_DEL,						ZX_KEY_DEL,					ZX_KEY_0)		//backspace
+SHIFTED(0x69,	0x69,	ZX_KEY_1,						ZX_KEY_EXCL)								//(keypad) 1
+SHIFTED(0x6B,	0x6B,	ZX_KEY_4,						ZX_KEY_DOLLAR)								//(keypad) 4
+SHIFTED(0x6C,	0x6C,	ZX_KEY_7,						ZX_KEY_AMPER)								//(keypad) 7
+SHIFTED(0x70,	0x70,	ZX_KEY_0,						ZX_KEY_ROUND_BRACKET_CLOSE)					//(keypad) 0
+CTRL(	0x71,	0x71,	ZX_KEY_PERIOD,					ZX_KEY_PERIOD,				ZX_KEY_M)		//(keypad) .
+SHIFTED(0x72,	0x72,	ZX_KEY_2,						ZX_KEY_AT)									//(keypad) 2
+SHIFTED(0x73,	0x73,	ZX_KEY_5,						ZX_KEY_PERCENT)								//(keypad) 5
+SHIFTED(0x74,	0x74,	ZX_KEY_6,						ZX_KEY_HAT)									//(keypad) 6
+SHIFTED(0x75,	0x75,	ZX_KEY_8,						ZX_KEY_STAR)								//(keypad) 8
+CTRL(	0x76,	0x08,	ZX_KEY_ESCAPE,					ZX_KEY_ESCAPE,				ZX_KEY_1)		//escape #### CP/M???
+CTRL(	0x77,	0x76,	ZX_KEY_CAT,						ZX_KEY_CAT,					ZX_KEY_9)		//NumberLock # Basic CAT command
+CTRL(	0x79,	0x7C,	ZX_KEY_PLUS,					ZX_KEY_PLUS,				ZX_KEY_K)		//(keypad) +
+SHIFTED(0x7A,	0x7A,	ZX_KEY_3,						ZX_KEY_HASH)								//(keypad) 3
+CTRL(	0x7B,	0x84,	ZX_KEY_MINUS,					ZX_KEY_MINUS,				ZX_KEY_J)		//(keypad) -
+CTRL(	0x7C,	0x7E,	ZX_KEY_STAR,					ZX_KEY_STAR,				ZX_KEY_B)		//(keypad) *
+SHIFTED(0x7D,	0x7D,	ZX_KEY_9,						ZX_KEY_ROUND_BRACKET_OPEN)					//(keypad) 9
+
+//0xE0 prefixed in set 2, sorted by their second byte
+EXT(	0x11,	0x39,	ZX_KEY_SYM)			//right alt
+EXT(	0x14,	0x58,	ZX_KEY_CTRL)			//right control, E mode then CAPS+SYM held
+EXT(	0x2F,	0x8D,	ZX_KEY_USR)			//menu (application) key, E mode + L
+EXT(	0x4A,	0x77,	ZX_KEY_SLASH)		//(keypad) /
+EXT(	0x5A,	0x79,	ZX_KEY_CR)			//(keypad) enter
+EXT(	0x6B,	0x61,	ZX_KEY_LEFT)			//cursor left
+EXT(	0x72,	0x60,	ZX_KEY_DOWN)			//cursor down
+EXT(	0x74,	0x6A,	ZX_KEY_RIGHT)		//cursor right
+EXT(	0x75,	0x63,	ZX_KEY_UP)			//cursor up
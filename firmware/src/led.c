@@ -0,0 +1,61 @@
+/*
+ * led.c
+ *
+ * Created: 17/10/2026 2:13:40 PM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+
+#include <config.h>
+
+#ifdef LED_BLINK
+
+#include <inttypes.h>
+#include <hal.h>
+#include <led.h>
+#include <pins.h>
+#include <ps2_kb.h>
+
+static uint8_t led_code;	//bits of the code being shown still to come, latched at the start of each pattern
+static uint8_t led_bit;		//bits left to show, 0 during the pause
+static uint16_t led_ms;		//until the next change
+
+
+//moves the LED pattern on by one ms; called from the timer interrupt
+//the LED pin itself tells whether a bit is being shown
+void led_tick(void){
+	if (led_ms>1) {
+		led_ms--;
+		return;
+	}
+	if (PORTD & (1 << LED)) {
+		PORTD&=~(1 << LED);
+		led_ms=--led_bit ? LED_GAP_MS : LED_PAUSE_MS;
+		return;
+	}
+	if (led_bit==0) {
+		led_code=last_scan_code;
+		led_bit=8;
+	}
+	PORTD|=1 << LED;
+	led_ms=(led_code & 0x80) ? LED_ONE_MS : LED_ZERO_MS;
+	led_code<<=1;
+}
+
+#endif
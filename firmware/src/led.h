@@ -0,0 +1,47 @@
+/*
+ * led.h
+ *
+ * Created: 17/10/2026 2:14:05 PM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+
+#ifndef LED_H_
+#define LED_H_
+
+#include <inttypes.h>
+#include <config.h>
+
+//the status LED flashes the last scan code, most significant bit first: short for 1, long for 0
+#define LED_ONE_MS		32
+#define LED_ZERO_MS		128
+#define LED_GAP_MS		128
+#define LED_PAUSE_MS	512	//between codes
+
+#ifdef LED_BLINK
+
+void led_tick(void);
+
+#else
+
+#define led_tick()
+
+#endif
+
+#endif /* LED_H_ */
@@ -0,0 +1,21 @@
+//generated from macros.txt by tools/macros.py, edit that file instead
+
+#ifndef MACROS_H_
+#define MACROS_H_
+
+//RANDOMIZE USR 14446\n
+#define MACRO_CPM_RUN_PROFILE MACRO_PROFILE_BASIC
+const MACRO_MEM uint8_t MACRO_CPM_RUN[]={ZX_KEY_T, ZX_KEY_USR, ZX_KEY_1, ZX_KEY_4, ZX_KEY_4, ZX_KEY_4, ZX_KEY_6, ZX_KEY_CR};
+
+//LOAD *"d";1;"
+#define MACRO_LOAD_FROM_DISK_PROFILE MACRO_PROFILE_BASIC
+const MACRO_MEM uint8_t MACRO_LOAD_FROM_DISK[]={ZX_KEY_J, ZX_KEY_STAR, ZX_KEY_DOUBLE_QUOTE, ZX_KEY_D, ZX_KEY_DOUBLE_QUOTE, ZX_KEY_SEMICOLON, ZX_KEY_1, ZX_KEY_SEMICOLON, ZX_KEY_DOUBLE_QUOTE};
+
+//PRINT "SVP2024"\n
+#define MACRO_SVP2024_PROFILE MACRO_PROFILE_BASIC
+const MACRO_MEM uint8_t MACRO_SVP2024[]={ZX_KEY_P, ZX_KEY_DOUBLE_QUOTE, ZX_CAP(ZX_KEY_S), ZX_CAP(ZX_KEY_V), ZX_CAP(ZX_KEY_P), ZX_KEY_2, ZX_KEY_0, ZX_KEY_2, ZX_KEY_4, ZX_KEY_DOUBLE_QUOTE, ZX_KEY_CR};
+
+//bytes all the macros take, checked against the EEPROM size
+#define MACROS_SIZE (sizeof(MACRO_CPM_RUN)+sizeof(MACRO_LOAD_FROM_DISK)+sizeof(MACRO_SVP2024))
+
+#endif /* MACROS_H_ */
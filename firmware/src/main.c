@@ -23,12 +23,14 @@
 
 //see avrlib and examples
 
-#include <avr/io.h>
+#include <hal.h>
 #include <MT8808.h>
-#include <util/delay.h>
-#include <avr/interrupt.h>
 #include <pins.h>
 #include <ps2_kb.h>
+#include <timer.h>
+#include <telemetry.h>
+#include <paste.h>
+#include <mouse.h>
 
 
 
@@ -45,33 +47,45 @@ void init_ports(void){
 }
 
 
-void blink_led(void){	
-	for (int8_t i=7; i>=0; i--) {
-		PORTD |=(1 << LED);	
-		if ((last_scan_code & (1 << i))>0) _delay_ms(32);
-		else _delay_ms(128);
-		PORTD&=~(1 << LED);		
-		_delay_ms(128);
-	}	
-	PORTD &=~(1 << LED);
-	_delay_ms(512);
+//sleeps until the next interrupt unless a scan code or a mouse byte is already waiting
+//the timer wakes the loop every ms, INT0 and INT1 on every falling clock edge, the paste receiver on every bit
+void idle(void){
+	cli();
+	if (kb_idle() && mouse_idle()) {
+		sleep_enable();
+		sei();//the instruction after sei still runs before any interrupt, so no wake up is lost
+		sleep_cpu();
+		cli();//sleep_disable() rewrites MCUCR, which holds the INT0 and INT1 sense bits too
+		sleep_disable();
+	}
+	sei();
 }
 
 
 int main(void)
 {
 	init_ports();
+	init_telemetry();//before anything it reports
 	MT8808_reset();
 	
 	init_kb();		
+	init_mouse();
+	init_timer();
+	init_paste();//after the timer, it adds to its settings
 	
 	GIMSK|=1<<INT0; //GIMSK=0x40; enable int0
 	
+	set_sleep_mode(SLEEP_MODE_IDLE);//timer 1, INT0 and INT1 keep running
 	sei();//enable global interrupts
 	
+	config_kb();//poll_kb() sends the commands, the keyboard answers once interrupts are on
+	config_mouse();
+	
     while (1) 
     {		
-		blink_led();
+		poll_kb();
+		poll_mouse();
+		idle();
     }
 }
 
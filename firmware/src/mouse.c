@@ -0,0 +1,277 @@
+/*
+ * mouse.c
+ *
+ * Created: 17/10/2026 7:06:14 PM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+//the receiver takes falling edges only, one interrupt per bit, and does no more than shift the bit
+//in and queue the byte; a data bit stays valid for the whole low half of the clock, 30 us or more,
+//so either receiver can wait for the other one and for the short timer interrupts without losing it
+//packets, acceleration and the cursor key taps are all worked out in poll_mouse()
+
+#include <config.h>
+
+#ifdef PS2_MOUSE
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <hal.h>
+#include <pins.h>
+#include <timer.h>
+#include <MT8808.h>
+#include <zx_keys.h>
+#include <ps2_kb.h>
+#include <mouse.h>
+
+//first packet byte
+#define MOUSE_LEFT			0x01
+#define MOUSE_RIGHT			0x02
+#define MOUSE_MIDDLE		0x04
+#define MOUSE_ALWAYS_1		0x08
+#define MOUSE_X_SIGN		0x10
+#define MOUSE_Y_SIGN		0x20
+#define MOUSE_X_OVERFLOW	0x40
+#define MOUSE_Y_OVERFLOW	0x80
+#define MOUSE_BUTTONS		3
+#define MOUSE_SEQ_ACTIONS	6	//switch actions of one packet: Enter, Space, CAPS and Space for Break, then CAPS and a cursor digit
+
+volatile static uint8_t mouse_buf[MOUSE_BUF_SIZE];
+volatile static uint8_t mouse_buf_head,mouse_buf_tail;
+volatile static uint8_t mouse_bit;				//0 waits for the start bit, 9 is parity, 10 stop
+volatile static uint8_t mouse_rx;
+volatile static uint8_t mouse_parity;
+volatile static uint16_t mouse_last_edge;
+volatile static bool mouse_reply_wanted;		//the next byte answers a command and is not queued
+volatile static uint8_t mouse_reply;
+volatile uint8_t mouse_frame_errors;
+
+static uint8_t mouse_packet[3];
+static uint8_t mouse_pos;
+static uint8_t mouse_buttons;
+static bool mouse_plugged;						//self test passed, reporting has to be turned on
+//motion not typed yet, in counts after acceleration
+static int16_t mouse_x,mouse_y;
+static uint8_t mouse_key;						//cursor key held, 0 between taps
+static uint8_t mouse_prev;
+static uint16_t mouse_due;
+
+//speed, in counts per packet over 4, to the factor the counts are multiplied with
+static const PROGMEM uint8_t MOUSE_ACCEL[]={1,1,2,2,3,3,4,4};
+
+static const PROGMEM uint8_t MOUSE_BUTTON_KEYS[MOUSE_BUTTONS]={
+	ZX_KEY_CR,				//left
+	ZX_KEY_SP,				//right
+	ZX_KEY_BREAK			//middle
+};
+
+
+void init_mouse(void){
+	mouse_buf_head=0;
+	mouse_buf_tail=0;
+	mouse_bit=0;
+	mouse_reply_wanted=false;
+	mouse_frame_errors=0;
+	mouse_pos=0;
+	mouse_buttons=0;
+	mouse_plugged=false;
+	mouse_x=0;
+	mouse_y=0;
+	mouse_key=0;
+	mouse_prev=0;
+	MCUCR=(MCUCR & ~((1<<ISC11) | (1<<ISC10))) | (1<<ISC11);	//INT1 on falling edge
+	EIFR=1<<INTF1;
+	GIMSK|=1<<INT1;
+}
+
+
+ISR (INT1_vect) {
+	uint8_t bit=PIND & (1<<MOUSE_DATA);
+	uint16_t now=TCNT1;
+	//a long gap means an edge was missed, this one starts over
+	if ((uint16_t)(now-mouse_last_edge)>PS2_EDGE_TIMEOUT) mouse_bit=0;
+	mouse_last_edge=now;
+	if (mouse_bit==0) {
+		//start bit must be 0, otherwise keep waiting for one
+		if (bit) return;
+		mouse_parity=0;
+	}
+	else if (mouse_bit<9) {
+		mouse_rx>>=1;
+		if (bit) {
+			mouse_rx|=0x80;
+			mouse_parity^=1;
+		}
+	}
+	else if (mouse_bit==9) {
+		//parity makes the number of ones odd
+		if (bit) mouse_parity^=1;
+	}
+	else {
+		mouse_bit=0;
+		if (!bit || !mouse_parity) mouse_frame_errors++;
+		else if (mouse_reply_wanted) {
+			mouse_reply=mouse_rx;
+			mouse_reply_wanted=false;
+		}
+		else {
+			uint8_t next=(mouse_buf_head+1) & (MOUSE_BUF_SIZE-1);
+			if (next!=mouse_buf_tail) {
+				mouse_buf[mouse_buf_head]=mouse_rx;
+				mouse_buf_head=next;
+			}
+		}
+		return;
+	}
+	mouse_bit++;
+}
+
+
+//sends a command until the mouse answers FA; needs interrupts on
+static bool mouse_command(uint8_t byte){
+	bool ack=false;
+	for (uint8_t tries=PS2_TX_TRIES; (tries>0) && !ack; tries--) {
+		bool sent;
+		GIMSK&=~(1<<INT1);
+		mouse_reply=0;
+		mouse_reply_wanted=true;
+		sent=ps2_send_frame(MOUSE_CLK,MOUSE_DATA,byte);
+		//start over on the next frame; drop the edges the host made itself
+		mouse_bit=0;
+		EIFR=1<<INTF1;
+		GIMSK|=1<<INT1;
+		if (sent) {
+			for (uint8_t ms=PS2_REPLY_MS; (ms>0) && mouse_reply_wanted; ms--) _delay_ms(1);
+			ack=(mouse_reply==PS2_REPLY_ACK);
+		}
+	}
+	mouse_reply_wanted=false;
+	return ack;
+}
+
+
+//a mouse comes up with reporting off; called after power up and whenever it reports a passed self test
+void config_mouse(void){
+	mouse_command(PS2_CMD_ENABLE_REPORTING);
+}
+
+
+static int16_t mouse_abs(int16_t value){
+	return (value<0) ? -value : value;
+}
+
+
+//9 bit two's complement motion; an overflow counts as the fastest motion
+static int16_t mouse_motion(uint8_t value, uint8_t sign, uint8_t overflow){
+	int16_t counts=sign ? (int16_t)value-256 : value;
+	if (overflow) counts=sign ? -255 : 255;
+	uint8_t speed=(uint8_t)(mouse_abs(counts)>>2);
+	if (speed>=sizeof(MOUSE_ACCEL)) speed=sizeof(MOUSE_ACCEL)-1;
+	return counts*pgm_read_byte(&MOUSE_ACCEL[speed]);
+}
+
+
+//adds the motion and keeps at most MOUSE_MAX_STEPS owed
+static int16_t mouse_add(int16_t owed, int16_t counts){
+	const int16_t limit=MOUSE_STEP_COUNTS*MOUSE_MAX_STEPS;
+	owed+=counts;
+	if (owed>limit) owed=limit;
+	if (owed<-limit) owed=-limit;
+	return owed;
+}
+
+
+static void mouse_packet_in(void){
+	uint8_t flags=mouse_packet[0];
+	uint8_t changed=(flags ^ mouse_buttons) & (MOUSE_LEFT | MOUSE_RIGHT | MOUSE_MIDDLE);
+	mouse_x=mouse_add(mouse_x,mouse_motion(mouse_packet[1],flags & MOUSE_X_SIGN,flags & MOUSE_X_OVERFLOW));
+	mouse_y=mouse_add(mouse_y,mouse_motion(mouse_packet[2],flags & MOUSE_Y_SIGN,flags & MOUSE_Y_OVERFLOW));
+	//buttons are held keys, they go through the same crosspoint counts as the keyboard
+	for (uint8_t i=0; i<MOUSE_BUTTONS; i++) {
+		if (changed & (1<<i)) zx_key_switch(pgm_read_byte(&MOUSE_BUTTON_KEYS[i]),flags & (1<<i),0);
+	}
+	mouse_buttons=flags;
+}
+
+
+//the cursor key for the larger motion owed, 0 when none is owed a whole step
+static uint8_t mouse_next_key(void){
+	if ((mouse_abs(mouse_x)>=mouse_abs(mouse_y)) && (mouse_abs(mouse_x)>=MOUSE_STEP_COUNTS)) {
+		return (mouse_x>0) ? ZX_KEY_RIGHT : ZX_KEY_LEFT;
+	}
+	if (mouse_abs(mouse_y)>=MOUSE_STEP_COUNTS) return (mouse_y>0) ? ZX_KEY_UP : ZX_KEY_DOWN;
+	return 0;
+}
+
+
+//one tap at a time: the key is held MOUSE_HOLD_MS, and the next one waits its gap after the release
+static void mouse_cursor(void){
+	uint16_t now=timer_millis();
+	if (mouse_key) {
+		if ((int16_t)(now-mouse_due)<0) return;
+		zx_key_switch(mouse_key,0,0);
+		mouse_prev=mouse_key;
+		mouse_key=0;
+		mouse_due=now;
+		return;
+	}
+	uint8_t key=mouse_next_key();
+	if (!key) return;
+	if ((int16_t)(now-mouse_due)<((key==mouse_prev) ? MOUSE_REPEAT_GAP_MS : MOUSE_GAP_MS)) return;
+	if (key==ZX_KEY_RIGHT) mouse_x-=MOUSE_STEP_COUNTS;
+	else if (key==ZX_KEY_LEFT) mouse_x+=MOUSE_STEP_COUNTS;
+	else if (key==ZX_KEY_UP) mouse_y-=MOUSE_STEP_COUNTS;
+	else mouse_y+=MOUSE_STEP_COUNTS;
+	zx_key_switch(key,1,0);
+	mouse_key=key;
+	mouse_due=now+MOUSE_HOLD_MS;
+}
+
+
+//drains the received bytes into packets and types the motion; called from the main loop
+void poll_mouse(void){
+	//wait for the switch queue to take a whole packet rather than block in MT8808_queue_list()
+	while ((mouse_buf_tail!=mouse_buf_head) && (MT8808_queue_free()>=MOUSE_SEQ_ACTIONS)) {
+		uint8_t byte=mouse_buf[mouse_buf_tail];
+		mouse_buf_tail=(mouse_buf_tail+1) & (MOUSE_BUF_SIZE-1);
+		if (mouse_pos==0) {
+			//AA then the 00 id after a self test; a first byte always has bit 3 set, which also finds the
+			//packet boundary again after a lost byte
+			if (byte==PS2_REPLY_BAT_OK) mouse_plugged=true;
+			if ((byte==PS2_REPLY_BAT_OK) || !(byte & MOUSE_ALWAYS_1)) continue;
+		}
+		mouse_packet[mouse_pos++]=byte;
+		if (mouse_pos==sizeof(mouse_packet)) {
+			mouse_pos=0;
+			mouse_packet_in();
+		}
+	}
+	if (mouse_plugged) {
+		mouse_plugged=false;
+		config_mouse();
+	}
+	if (MT8808_queue_free()>=MOUSE_SEQ_ACTIONS) mouse_cursor();
+}
+
+
+bool mouse_idle(void){
+	return mouse_buf_tail==mouse_buf_head;
+}
+
+#endif
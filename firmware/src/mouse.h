@@ -0,0 +1,63 @@
+/*
+ * mouse.h
+ *
+ * Created: 17/10/2026 7:05:52 PM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+//optional PS/2 mouse on MOUSE_CLK (INT1) and MOUSE_DATA, next to the keyboard on INT0
+//motion becomes taps of the cursor keys, faster motion more of them; the buttons are keys held
+//for as long as the button is down: left ENTER, right SPACE, middle BREAK (CAPS+SPACE)
+
+
+#ifndef MOUSE_H_
+#define MOUSE_H_
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <config.h>
+
+#define PS2_CMD_ENABLE_REPORTING	0xF4
+
+#define MOUSE_STEP_COUNTS	16	//counts per cursor step after acceleration; the mouse starts at 4 counts per mm
+#define MOUSE_MAX_STEPS		4	//steps owed at most, so the cursor stops soon after the mouse does
+//the ROM only takes a key that stays down a frame, and the same key again after 5 frames up
+#define MOUSE_HOLD_MS		30
+#define MOUSE_GAP_MS		40
+#define MOUSE_REPEAT_GAP_MS	120
+
+#ifdef PS2_MOUSE
+
+extern volatile uint8_t mouse_frame_errors;
+
+void init_mouse(void);
+void config_mouse(void);
+void poll_mouse(void);
+bool mouse_idle(void);
+
+#else
+
+#define init_mouse()
+#define config_mouse()
+#define poll_mouse()
+#define mouse_idle() true
+
+#endif
+
+#endif /* MOUSE_H_ */
@@ -0,0 +1,137 @@
+/*
+ * paste.c
+ *
+ * Created: 17/10/2026 5:12:31 PM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+//the input capture interrupt finds the start bit, then compare B samples the middle of each bit;
+//both run off the free running timer 1, so the 1 ms tick on compare A is not disturbed
+
+#include <config.h>
+
+#ifdef PASTE
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <hal.h>
+#include <pins.h>
+#include <timer.h>
+#include <paste.h>
+
+#define PASTE_BIT_TICKS	((F_CPU/TIMER_PRESCALER+PASTE_BAUD/2)/PASTE_BAUD)
+#define PASTE_UBRR		((F_CPU/16+PASTE_BAUD/2)/PASTE_BAUD-1)
+
+_Static_assert(PASTE_BIT_TICKS>=8,"PASTE_BAUD is too fast for timer 1 at this F_CPU");
+
+static volatile uint8_t rx_buf[PASTE_BUF_SIZE];
+static volatile uint8_t rx_head,rx_tail;
+static uint8_t rx_shift;
+static uint8_t rx_bit;			//data bits sampled so far, 8 at the stop bit
+static volatile bool rx_stopped;	//XOFF sent
+static volatile uint8_t tx_flow;	//XON or XOFF waiting for the transmitter
+
+
+void init_paste(void){
+	DDRD&=~(1<<PASTE_RX);
+	PORTD|=1<<PASTE_RX;				//pull up, the line idles high
+	TCCR1B|=1<<ICNC1;				//falling edge, noise canceler on
+	TIFR=1<<ICF1;
+	TIMSK|=1<<ICIE1;
+	//the transmitter only sends XON/XOFF
+	UBRRH=(uint8_t)(PASTE_UBRR>>8);
+	UBRRL=(uint8_t)PASTE_UBRR;
+	UCSRB=1<<TXEN;
+	rx_head=0;
+	rx_tail=0;
+	rx_stopped=false;
+}
+
+
+//the data register empty interrupt sends it, nothing waits for the transmitter with interrupts off;
+//a newer byte replaces one not sent yet, only the last of XON and XOFF matters
+static void paste_send(uint8_t byte){
+	tx_flow=byte;
+	UCSRB|=1<<UDRIE;
+}
+
+
+ISR(USART_UDRE_vect){
+	UDR=tx_flow;
+	UCSRB&=~(1<<UDRIE);
+}
+
+
+ISR(TIMER1_CAPT_vect){
+	OCR1B=ICR1+PASTE_BIT_TICKS+PASTE_BIT_TICKS/2;	//middle of the first data bit
+	TIFR=1<<OCF1B;
+	TIMSK=(TIMSK & ~(1<<ICIE1)) | (1<<OCIE1B);
+	rx_bit=0;
+}
+
+
+ISR(TIMER1_COMPB_vect){
+	uint8_t level=PIND & (1<<PASTE_RX);
+	OCR1B+=PASTE_BIT_TICKS;
+	if (rx_bit<8) {
+		rx_shift>>=1;
+		if (level) rx_shift|=0x80;
+		rx_bit++;
+		return;
+	}
+	//a low stop bit is a framing error, the byte is dropped
+	if (level) {
+		uint8_t next=(rx_head+1) & (PASTE_BUF_SIZE-1);
+		if (next!=rx_tail) {
+			rx_buf[rx_head]=rx_shift;
+			rx_head=next;
+		}
+		if (!rx_stopped && (((rx_head-rx_tail) & (PASTE_BUF_SIZE-1))>=PASTE_XOFF_COUNT)) {
+			paste_send(PASTE_XOFF);
+			rx_stopped=true;
+		}
+	}
+	//the next start bit can come as soon as the stop bit ends
+	TIFR=1<<ICF1;
+	TIMSK=(TIMSK & ~(1<<OCIE1B)) | (1<<ICIE1);
+}
+
+
+uint8_t paste_count(void){
+	return (rx_head-rx_tail) & (PASTE_BUF_SIZE-1);
+}
+
+
+//i-th byte waiting, i below paste_count()
+uint8_t paste_peek(uint8_t i){
+	return rx_buf[(rx_tail+i) & (PASTE_BUF_SIZE-1)];
+}
+
+
+void paste_drop(uint8_t n){
+	rx_tail=(rx_tail+n) & (PASTE_BUF_SIZE-1);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		if (rx_stopped && (paste_count()<=PASTE_XON_COUNT)) {
+			paste_send(PASTE_XON);
+			rx_stopped=false;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * paste.h
+ *
+ * Created: 17/10/2026 5:12:08 PM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+//optional text input from a host: a receive only software UART on UNUSED_IO, 8N1 at PASTE_BAUD
+//the bytes are typed by the macro player in ps2_kb.c, the hardware UART sends XOFF when the buffer
+//is half full and XON once it has drained to a quarter; tools/paste.py is the host side
+//
+//the text is ASCII, \n is ENTER and \r is ignored; the control bytes below give the keys and
+//timing plain text cannot
+
+
+#ifndef PASTE_H_
+#define PASTE_H_
+
+#include <inttypes.h>
+#include <config.h>
+
+#define PASTE_RAW		0x01	//the next byte is a ZX key code, e.g. a keyword or E mode key
+#define PASTE_PROFILE	0x02	//the next byte is the macro_profile_t to type with from now on
+#define PASTE_PAUSE		0x03	//the next byte is a pause in 10 ms units, e.g. while the ROM checks a line
+#define PASTE_XON		0x11
+#define PASTE_XOFF		0x13
+
+#define PASTE_XOFF_COUNT	(PASTE_BUF_SIZE/2)	//bytes waiting when XOFF goes out; the other half takes what a PC UART still sends from its FIFO
+#define PASTE_XON_COUNT		(PASTE_BUF_SIZE/4)	//bytes waiting when XON goes out
+#define PASTE_IDLE_MS	500		//the keyboard is back once the host has been quiet this long, well over the longest gap
+
+#ifdef PASTE
+
+void init_paste(void);
+uint8_t paste_count(void);
+uint8_t paste_peek(uint8_t i);
+void paste_drop(uint8_t n);
+
+#else
+
+#define init_paste()
+#define paste_count() 0
+
+#endif
+
+#endif /* PASTE_H_ */
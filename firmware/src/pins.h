@@ -25,7 +25,7 @@
 #ifndef PINS_H_
 #define PINS_H_
 
-#include <avr/io.h>
+#include <hal.h>
 
 #define AX0			PB0
 #define AX1			PB1
@@ -43,6 +43,9 @@
 #define KBD_DATA	PD4	//input
 #define MOUSE_DATA	PD5	//input
 #define UNUSED_IO	PD6	//input
+#define TELEMETRY_TX	UNUSED_IO	//output when TELEMETRY is defined
+#define PASTE_RX		UNUSED_IO	//input when PASTE is defined, also ICP1
+#define PASTE_TX		LED			//USART TXD, XON/XOFF when PASTE is defined
 
 
 
@@ -24,246 +24,1164 @@
 
 #include <inttypes.h>
 #include <stdbool.h>
-#include <avr/interrupt.h>
-#include <avr/pgmspace.h>
-#include <avr/eeprom.h>
-#include <MT8808.h> //before delay so F_CPU is defined
-#include <util/delay.h>
+#include <stddef.h>
+#include <hal.h>
+#include <config.h>
+#include <MT8808.h>
 #include <ps2_kb.h>
 #include <scan_code_lookup.h>
 #include <pins.h>
+#include <timer.h>
+#include <telemetry.h>
+#include <paste.h>
 
+#if defined(PS2_SCAN_CODE_SET3) && !defined(KB_COMMANDS)
+#error "scan code set 3 is selected by a command to the keyboard, define KB_COMMANDS"
+#endif
 
 #define E_MODE_DELAY 30
-#define MACRO_TYPE_DELAY 50
 
+//the most switch actions one step of poll_kb() queues: an E mode key is tapped (3 on, 3 off), the key closed
+//and the shared CAPS or SYM opened (3), the oldest held key released (3), and a synthesized repeat closed again (3)
+#ifdef KB_REPEAT_SYNTH
+#define KB_SEQ_ACTIONS 15
+#else
+#define KB_SEQ_ACTIONS 12
+#endif
+_Static_assert(MT8808_QUEUE_SIZE>KB_SEQ_ACTIONS,"MT8808_QUEUE_SIZE must hold the longest key sequence");
+
+#define KB_STUCK_TIMEOUT 750 //ms; the keyboard repeats a held key KB_TYPEMATIC 500 ms after the make, then every 200 ms
+
+//INT0 sense bits only, MCUCR also holds those of INT1 and the sleep mode
+#define KB_EDGE_FALLING()	(MCUCR=(MCUCR & ~((1<<ISC01) | (1<<ISC00))) | (1<<ISC01))
 
-volatile static uint8_t ps2_scan_code;                // Holds the received scan code
-volatile static uint8_t edge,bitcount;
+#define PS2_TX_START_US 15000 //the keyboard starts clocking at most 15 ms after the request to send
+#define PS2_TX_EDGE_US 100 //and then keeps a clock edge every 30..50 us
+#define PS2_TX_MS 20 //a whole frame to the keyboard, its start included
 
-typedef enum PS2_KEY_DECODE_STATE{
-	PS2_STATE_IDLE_WAIT_FOR_EVENT,
-	PS2_STATE_KEY_PRESSED,
-	PS2_STATE_KEY_RELEASED
-} key_decode_state_t;
 
-volatile key_decode_state_t state;
-volatile bool ps2_ext_key_code;
-volatile bool ps2_RIGHT_SHIFT_key_PRESSED;
-volatile bool zx_digit_symbol_shift;
-volatile bool zx_digit_symbol_shifted;
-volatile bool ps2_RIGHT_SHIFTED_symbols;
+volatile uint8_t last_scan_code;
+
+volatile static uint8_t ps2_scan_code;                // Holds the scan code being decoded
+volatile static uint8_t ps2_rx_code;                  // Shift register of the INT0 receiver
+volatile static uint8_t bitcount;
+volatile static uint8_t ps2_rx_parity;
+volatile static uint16_t ps2_last_edge;               // TCNT1 at the previous falling clock edge
+volatile uint8_t ps2_frame_errors;                    // bad start, parity or stop bits and missed edges
+volatile uint8_t ps2_buf_overruns;                    // bytes dropped on a full ps2_buf, e.g. typed during a long macro
+static uint8_t ps2_buf_overruns_seen;
+#ifdef KB_COMMANDS
+volatile static uint8_t ps2_reply;                    // FA or FE answer to the last command, never decoded
+static uint8_t kb_leds;
+//a byte to the keyboard goes out from INT0 one bit per falling clock edge, see ps2_tx_start()
+#define PS2_TX_ACK			10	//falling edge where the keyboard acknowledges the frame
+#define PS2_TX_IDLE			0xFF
+volatile static uint8_t ps2_tx_bit;                   // falling edges of the frame so far, PS2_TX_IDLE when none is sent
+volatile static uint16_t ps2_tx_frame;                // bits still to send, data first, then parity and stop
+
+//commands waiting for the keyboard, sent one byte at a time from poll_kb(); the bits are in sending order
+#define KB_CMD_SCAN_SET		0x01	//F0 03, set 3 only
+#define KB_CMD_MAKE_BREAK	0x02	//F8, set 3 only
+#define KB_CMD_TYPEMATIC	0x04	//F3 KB_TYPEMATIC
+#define KB_CMD_LEDS			0x08	//ED kb_leds, the value when it goes out
+static uint8_t kb_cmd_due;
+static uint8_t kb_cmd[2];                              // the command being sent and its argument
+static uint8_t kb_cmd_len,kb_cmd_pos;
+static uint8_t kb_cmd_tries;
+static bool kb_cmd_busy;                              // a byte is out, waiting for its FA
+static uint16_t kb_cmd_time;                          // timer_millis() when it went out
+#endif
+
+//single producer (INT0) single consumer (main loop) ring buffer of received bytes
+//head is only written by the ISR, tail only by poll_kb(), so no locking is needed
+volatile static uint8_t ps2_buf[PS2_BUF_SIZE];
+volatile static uint8_t ps2_buf_head,ps2_buf_tail;
+
+//decoder state, one byte: the prefixes seen so far in the low bits, the modifiers held above them
+//the prefix is the row of KB_TRANSITIONS; the modifiers only change in its actions
+#define KB_PREFIX_NONE		0
+#define KB_PREFIX_E0		1	//the next code is an extended one
+#define KB_PREFIX_F0		2	//the next code is a break
+#define KB_PREFIX_E0_F0		3	//extended break
+#define KB_PREFIXES			4
+#define KB_PREFIX_MASK		0x03
+#define KB_PREFIX_EXT		0x01	//set in both extended prefixes
+#define KB_MOD_RSHIFT		0x04	//right shift down
+#define KB_MOD_SYM			0x08	//a SYM key held
+#define KB_MOD_CTRL			0x10	//a Ctrl key held, it closed CAPS and SYM after its E mode tap
+
+//what decode() makes of a byte before looking at the state
+typedef enum KB_BYTE_CLASS{
+	KB_BYTE_NONE,		//Esc taken out of the buffer by an aborted macro
+	KB_BYTE_E0,
+	KB_BYTE_F0,
+	KB_BYTE_KEY,		//PS2_CODE_FIRST..PS2_CODE_LAST
+	KB_BYTE_RSHIFT,
+	KB_BYTE_HOTKEY,		//F1..F4, F12 and Scroll Lock, see macro_hotkey()
+	KB_BYTE_BAT,		//self test passed, the keyboard was plugged in or reset
+	KB_BYTE_E1,			//first byte of a KB_SEQUENCES entry
+	KB_BYTE_OTHER,		//none of these: a key with no code here (F7 is 83), an echo, overrun or failed self test
+	KB_BYTE_CLASSES
+} kb_byte_class_t;
+
+//the makes come last, the keyboard repeats them
+typedef enum KB_ACTION{
+	KB_ACT_NONE,
+	KB_ACT_RELEASE,
+	KB_ACT_RSHIFT_UP,
+	KB_ACT_HOTKEY_UP,
+	KB_ACT_BAT,
+	KB_ACT_PRESS,
+	KB_ACT_RSHIFT_DOWN,
+	KB_ACT_HOTKEY_DOWN,
+	KB_ACT_SEQUENCE
+} kb_action_t;
+
+//one entry per prefix and byte class: the action in the high bits, the next prefix in the low 2
+#define KB_GO(action,prefix)	(((action)<<2) | (prefix))
+#define KB_GO_ACTION(entry)		((kb_action_t)((entry)>>2))
+
+//bytes that fit nowhere only drop the prefix, the held keys stay as they are
+static const PROGMEM uint8_t KB_TRANSITIONS[KB_PREFIXES][KB_BYTE_CLASSES]={
+	{	//no prefix
+		KB_GO(KB_ACT_NONE,KB_PREFIX_NONE),				//none
+		KB_GO(KB_ACT_NONE,KB_PREFIX_E0),				//E0
+		KB_GO(KB_ACT_NONE,KB_PREFIX_F0),				//F0
+		KB_GO(KB_ACT_PRESS,KB_PREFIX_NONE),				//key
+		KB_GO(KB_ACT_RSHIFT_DOWN,KB_PREFIX_NONE),		//right shift
+		KB_GO(KB_ACT_HOTKEY_DOWN,KB_PREFIX_NONE),		//hot key
+		KB_GO(KB_ACT_BAT,KB_PREFIX_NONE),				//BAT
+		KB_GO(KB_ACT_SEQUENCE,KB_PREFIX_NONE),			//E1
+		KB_GO(KB_ACT_NONE,KB_PREFIX_NONE)				//other
+	},
+	{	//E0
+		KB_GO(KB_ACT_NONE,KB_PREFIX_E0),				//none
+		KB_GO(KB_ACT_NONE,KB_PREFIX_E0),				//E0
+		KB_GO(KB_ACT_NONE,KB_PREFIX_E0_F0),				//F0
+		KB_GO(KB_ACT_PRESS,KB_PREFIX_NONE),				//key
+		KB_GO(KB_ACT_PRESS,KB_PREFIX_NONE),				//right shift
+		KB_GO(KB_ACT_NONE,KB_PREFIX_NONE),				//hot key, there are no extended ones
+		KB_GO(KB_ACT_BAT,KB_PREFIX_NONE),				//BAT
+		KB_GO(KB_ACT_SEQUENCE,KB_PREFIX_NONE),			//E1
+		KB_GO(KB_ACT_NONE,KB_PREFIX_NONE)				//other
+	},
+	{	//F0
+		KB_GO(KB_ACT_NONE,KB_PREFIX_F0),				//none
+		KB_GO(KB_ACT_NONE,KB_PREFIX_E0),				//E0, the F0 before it was not for the next code
+		KB_GO(KB_ACT_NONE,KB_PREFIX_F0),				//F0
+		KB_GO(KB_ACT_RELEASE,KB_PREFIX_NONE),			//key
+		KB_GO(KB_ACT_RSHIFT_UP,KB_PREFIX_NONE),			//right shift
+		KB_GO(KB_ACT_HOTKEY_UP,KB_PREFIX_NONE),			//hot key
+		KB_GO(KB_ACT_BAT,KB_PREFIX_NONE),				//BAT
+		KB_GO(KB_ACT_SEQUENCE,KB_PREFIX_NONE),			//E1
+		KB_GO(KB_ACT_NONE,KB_PREFIX_NONE)				//other
+	},
+	{	//E0 F0
+		KB_GO(KB_ACT_NONE,KB_PREFIX_E0_F0),				//none
+		KB_GO(KB_ACT_NONE,KB_PREFIX_E0),				//E0
+		KB_GO(KB_ACT_NONE,KB_PREFIX_E0_F0),				//F0
+		KB_GO(KB_ACT_RELEASE,KB_PREFIX_NONE),			//key
+		KB_GO(KB_ACT_RELEASE,KB_PREFIX_NONE),			//right shift
+		KB_GO(KB_ACT_NONE,KB_PREFIX_NONE),				//hot key
+		KB_GO(KB_ACT_BAT,KB_PREFIX_NONE),				//BAT
+		KB_GO(KB_ACT_SEQUENCE,KB_PREFIX_NONE),			//E1
+		KB_GO(KB_ACT_NONE,KB_PREFIX_NONE)				//other
+	}
+};
+
+#ifndef PS2_SCAN_CODE_SET3
+//byte sequences that are not keys, each from a first byte nothing else starts with; the rest are matched
+//by kb_sequence() and the ZX key of the entry is tapped with the last one, PS2_NO_KEY for none
+//the fake shifts Print Screen and the cursor keys send (E0 12, E0 59) need no entry, PS2_E0_KEYS has no key for them
+#define KB_SEQ_BYTES	8
+static const PROGMEM uint8_t KB_SEQUENCES[][1+KB_SEQ_BYTES]={
+	//ZX key		bytes, PS2_NO_KEY after the last one of a shorter sequence
+	{ZX_KEY_BREAK,	0xE1,0x14,0x77,0xE1,0xF0,0x14,0xF0,0x77}	//pause, make and break come together
+};
+static uint8_t kb_seq;		//entry being matched
+static uint8_t kb_seq_pos;	//bytes of it matched so far, 0 when none is
+#endif
+
+static uint8_t kb_state;
+
+typedef enum MACRO_PLAYBACK_STEP{
+	MACRO_STEP_IDLE,
+	MACRO_STEP_PRESS,
+	MACRO_STEP_RELEASE
+} macro_step_t;
+
+#ifdef MACRO_RECORD
+typedef enum MACRO_RECORD_STATE{
+	MACRO_REC_OFF,
+	MACRO_REC_ARMED,	//F12 pressed, waiting for the slot key
+	MACRO_REC_ON
+} macro_rec_t;
+#endif
+
+static const uint8_t * macro_ptr;
+static uint8_t macro_pos;//next key to read
+static uint8_t macro_len;//keys in the macro being played
+#if defined(MACRO_RECORD) && !defined(MACRO_MEM_EE)
+static bool macro_recorded;//recorded macros are in EEPROM, the built in ones in flash
+#endif
+static macro_step_t macro_step;
+static uint8_t macro_code;//key to press next, then the key held
+static uint8_t macro_prev;//key typed before it
+static uint16_t macro_due;//release of the key before, or of the one held
+#ifdef PASTE
+static bool macro_pasting;//the keys come from the paste receiver instead
+static macro_profile_t paste_profile;
+#endif
+static uint8_t macro_key;//function key that started the macro, ignored while held
+static macro_profile_t macro_profile;
+
+//the ROM reads the keyboard once per 20 ms frame interrupt and tracks two keys, each until it has
+//been up for 5 frames; so a key has to stay down a little over a frame, a different key can follow
+//soon, but the same key again only once the ROM has forgotten it
+typedef enum MACRO_KEY_CLASS{
+	MACRO_KEY_PLAIN,
+	MACRO_KEY_SHIFTED,		//CAPS or SYM with the key, switched together
+	MACRO_KEY_E_MODE,		//CAPS+SYM tap, then the key E_MODE_DELAY later
+	MACRO_KEY_REPEATED,		//same key as the one before
+	MACRO_KEY_CLASSES
+} macro_key_class_t;
+
+#define MACRO_GAP	0	//ms from the release of the previous key to the press
+#define MACRO_HOLD	1	//ms from the press to the release
+
+static const PROGMEM uint8_t MACRO_TIMING[MACRO_PROFILES][MACRO_KEY_CLASSES][2]={
+	//plain		shifted		E mode					repeated
+	{{100,50},	{100,50},	{100,E_MODE_DELAY+50},	{120,50}},	//safe
+	{{50,30},	{50,30},	{50,E_MODE_DELAY+30},	{120,30}},	//BASIC, the editor redraws the line after a keyword
+	{{40,30},	{40,30},	{40,E_MODE_DELAY+30},	{120,30}}	//CP/M
+};
+
+#ifdef MACRO_RECORD
+//recorded macros, one byte ZX key code per key; the codes, the length and the checksum add up to 0
+//the length is written last and stays 0xFF, never valid, while a recording is in progress
+#define MACRO_SLOT_LENGTH	0
+#define MACRO_SLOT_CHECKSUM	1
+#define MACRO_SLOT_CODES	2
+#define MACRO_SLOT_KEYS		(MACRO_SLOT_SIZE-MACRO_SLOT_CODES)
+
+static uint8_t EEMEM macro_slot[MACRO_SLOTS][MACRO_SLOT_SIZE];
+static macro_rec_t macro_rec;
+static uint8_t macro_rec_slot;
+static uint8_t macro_rec_len;//keys recorded so far
+static uint8_t macro_rec_sum;
+#define MACRO_SLOTS_SIZE	sizeof(macro_slot)
+#else
+#define MACRO_SLOTS_SIZE	0
+#endif
+
+#ifdef KB_CPM_PROFILE
+static kb_profile_t kb_profile;
+static uint8_t EEMEM kb_profile_saved;
+#define KB_PROFILE_SIZE		sizeof(kb_profile_saved)
+#else
+#define kb_profile			KB_PROFILE_BASIC
+#define KB_PROFILE_SIZE		0
+#endif
+
+#ifdef MACRO_MEM_EE
+_Static_assert(MACRO_SLOTS_SIZE+MACROS_SIZE+KB_PROFILE_SIZE<=E2END+1,"the recorded and built in macros do not fit the EEPROM, lower MACRO_SLOT_SIZE");
+#else
+_Static_assert(MACRO_SLOTS_SIZE+KB_PROFILE_SIZE<=E2END+1,"the recorded macros do not fit the EEPROM, lower MACRO_SLOT_SIZE");
+#endif
+
+//keys whose crosspoints are closed, oldest first; bit 7 of the id marks an E0 code
+//the release opens exactly what the press closed, repeated makes of a held key only show it is still down
+static uint8_t held_id[KB_HELD_KEYS];
+static uint8_t held_zx[KB_HELD_KEYS];
+#ifdef KB_REPEAT_SYNTH
+static uint8_t held_e[KB_HELD_KEYS];                  // E mode key tapped before the held one
+static uint16_t repeat_due;
+static bool repeat_up;                                // the watched key is open between two repeats
+#endif
+static uint8_t held_count;
+//only the last pressed key keeps repeating, so only that one can be watched; set 3 keys do not repeat at all
+//a make of any other key or a command to the keyboard ends its repeat, its break code is waited for then
+static uint8_t watch_id;
+static uint16_t watch_seen;                           // last byte received, any byte restarts the timer
+static bool watch_repeats;
+volatile uint8_t kb_forced_releases;                  // keys released by the watchdog after a lost break code
+
+static void play_macro(void);
+#ifdef MACRO_RECORD
+static void macro_record_key(uint8_t zx_code);
+#endif
+static void kb_reset_matrix(void);
+static void kb_release_held(void);
+static void kb_watchdog(void);
+static void kb_profile_apply(void);
 
 void init_kb(void){
-	MCUCR=ISC10;                              //INT0 on falling edge
-	edge = 0;                                // 0 = falling edge  1 = rising edge
+	KB_EDGE_FALLING();
 	bitcount = 11;
 	ps2_scan_code=0;
-	MT8808_reset();
-//by default keyboard starts in code set 3
+	ps2_rx_code=0;
+	ps2_frame_errors=0;
+	ps2_buf_overruns=0;
+	ps2_buf_overruns_seen=0;
+	ps2_buf_head=0;
+	ps2_buf_tail=0;
+	kb_forced_releases=0;
+#ifdef KB_COMMANDS
+	kb_leds=0;
+	ps2_tx_bit=PS2_TX_IDLE;
+	kb_cmd_due=0;
+	kb_cmd_len=0;
+	kb_cmd_busy=false;
+#endif
+	kb_reset_matrix();
+	//the keyboard comes up in set 2 with its own typematic rate, config_kb() sets both once interrupts are on
 	PORTD |=(1 << LED);	
 	_delay_us(512);
 	PORTD&=~(1 << LED);	
 
-	state=PS2_STATE_IDLE_WAIT_FOR_EVENT;
-	ps2_ext_key_code=false;
-	ps2_RIGHT_SHIFT_key_PRESSED=false;
-	zx_digit_symbol_shift=false;
-	zx_digit_symbol_shifted=false;	
-	ps2_RIGHT_SHIFTED_symbols=false;
+	macro_step=MACRO_STEP_IDLE;
+	macro_key=PS2_NO_KEY;
+#ifdef MACRO_RECORD
+	macro_rec=MACRO_REC_OFF;
+#endif
+#ifdef KB_CPM_PROFILE
+	//an erased EEPROM reads 0xFF, BASIC then
+	kb_profile=(kb_profile_t)eeprom_read_byte(&kb_profile_saved);
+	if (kb_profile>=KB_PROFILES) kb_profile=KB_PROFILE_BASIC;
+#endif
+	kb_profile_apply();
 }
 
 
+#if defined(KB_COMMANDS) || defined(PS2_MOUSE)
+//lets a line float high through the pull-up, or pulls it low
+static void ps2_drive(uint8_t pin, uint8_t level){
+	if (level) {
+		DDRD&=~(1<<pin);
+		PORTD|=1<<pin;
+	}
+	else {
+		PORTD&=~(1<<pin);
+		DDRD|=1<<pin;
+	}
+}
+#endif
+
+//INT0 takes falling edges only: the keyboard sets each bit before it pulls the clock low
 ISR (INT0_vect) {
-    if (!edge) {
-		// Routine entered at falling edge
-	    if ((bitcount < 11) && (bitcount > 2)) {
-			// Bit 3 to 10 is data. Parity bit, start and stop bits are ignored.
-		    ps2_scan_code = (ps2_scan_code >> 1);//shift right and stores 0 in bit 7
-			if (PIND & (1<<KBD_DATA)) ps2_scan_code = ps2_scan_code | 0x80;  // Store a '1'
-		}		
-		// Set interrupt on rising edge (MCUCR=3)
-	    MCUCR = ISC11;                            
-	    edge = 1;	    
-	 } else {
-		// Routine entered at rising edge
-		// Set interrupt on falling edge (MCUCR=2)
-	    MCUCR = ISC10;                            
-	    edge = 0;
-	    if ((--bitcount) == 0) {
-			// All bits received
-		    bitcount = 11;
-			//last_scan_code=scan_code;
-		    decode();
-			ps2_scan_code=PS2_NO_KEY;
-	    }
-    }	
-}
-
-void ps2_scan_code_to_mt8808_switch(uint8_t scan_code){
+	uint8_t bit=PIND & (1<<KBD_DATA);
+#ifdef KB_COMMANDS
+	if (ps2_tx_bit!=PS2_TX_IDLE) {
+		//sending: the keyboard read the previous bit at the rising edge, the next is set while the clock is low
+		//after the stop bit it pulls data low for one more clock to acknowledge, then its answer comes as usual
+		if (ps2_tx_bit++<PS2_TX_ACK) {
+			ps2_drive(KBD_DATA,ps2_tx_frame & 1);
+			ps2_tx_frame>>=1;
+		}
+		else ps2_tx_bit=PS2_TX_IDLE;
+		return;
+	}
+#endif
+	uint16_t now=TCNT1;
+	//falling edges of one frame are a clock period apart, a long gap means one was missed; this one starts over
+	if ((bitcount!=11) && ((uint16_t)(now-ps2_last_edge)>PS2_EDGE_TIMEOUT)) {
+		ps2_frame_errors++;
+		bitcount=11;
+	}
+	ps2_last_edge=now;
+	if (bitcount==11) {
+		// Start bit must be 0, otherwise keep waiting for one
+		if (bit) {
+			ps2_frame_errors++;
+			return;
+		}
+		ps2_rx_parity=0;
+	}
+	else if (bitcount>2) {
+		// Bit 3 to 10 is data
+		ps2_rx_code = (ps2_rx_code >> 1);//shift right and stores 0 in bit 7
+		if (bit) {
+			ps2_rx_code = ps2_rx_code | 0x80;  // Store a '1'
+			ps2_rx_parity^=1;
+		}
+	}
+	else if (bitcount==2) {
+		// Parity bit makes the number of ones odd
+		if (bit) ps2_rx_parity^=1;
+	}
+	else {
+		// Stop bit, all bits received
+		bitcount=11;
+		if (!bit || !ps2_rx_parity) {
+			ps2_frame_errors++;
+			telemetry_event(TELEMETRY_FRAME_ERROR,ps2_frame_errors);
+		}
+#ifdef KB_COMMANDS
+		//answers to commands are for kb_cmd_poll() only
+		else if ((ps2_rx_code==PS2_REPLY_ACK) || (ps2_rx_code==PS2_REPLY_RESEND)) ps2_reply=ps2_rx_code;
+#endif
+		else {
+			//only queue the byte, decoding happens in the main loop
+			uint8_t next=(ps2_buf_head+1) & (PS2_BUF_SIZE-1);
+			if (next!=ps2_buf_tail) {
+				ps2_buf[ps2_buf_head]=ps2_rx_code;
+				ps2_buf_head=next;
+			}
+			else ps2_buf_overruns++;
+			telemetry_event(TELEMETRY_RX_BYTE,ps2_rx_code);
+		}
+		return;
+	}
+	bitcount--;
+}
+
+#ifdef PS2_MOUSE
+//waits for the device to drive its clock line to the given level
+static bool ps2_wait_clk(uint8_t clk, uint8_t level, uint16_t us){
+	while (((PIND>>clk) & 1)!=level) {
+		if (!us--) return false;
+		_delay_us(1);
+	}
+	return true;
+}
+
+//host to device frame: the host asks to send, the device clocks the bits in and acknowledges
+//the caller keeps the interrupt of that device off, the other device keeps receiving
+bool ps2_send_frame(uint8_t clk, uint8_t data, uint8_t byte){
+	bool ack=false;
+	uint8_t parity=1;
+	//inhibit for at least 100 us, then request to send
+	ps2_drive(clk,0);
+	_delay_us(120);
+	ps2_drive(data,0);
+	ps2_drive(clk,1);
+	uint8_t i;
+	//8 data bits, parity and stop are set while the clock is low
+	for (i=0;i<10;i++) {
+		if (!ps2_wait_clk(clk,0,(i==0) ? PS2_TX_START_US : PS2_TX_EDGE_US)) break;
+		uint8_t bit=1;//stop
+		if (i<8) {
+			bit=byte & 1;
+			byte>>=1;
+			parity^=bit;
+		}
+		else if (i==8) bit=parity;
+		ps2_drive(data,bit);
+		if (!ps2_wait_clk(clk,1,PS2_TX_EDGE_US)) break;
+	}
+	//the device pulls data low for one more clock to acknowledge
+	if ((i==10) && ps2_wait_clk(clk,0,PS2_TX_EDGE_US)) {
+		ack=!(PIND & (1<<data));
+		ps2_wait_clk(clk,1,PS2_TX_EDGE_US);
+	}
+	ps2_drive(data,1);
+	ps2_drive(clk,1);
+	return ack;
+}
+#endif
+
+#ifdef KB_COMMANDS
+//host to keyboard frame: after the inhibit and the request to send INT0 takes over, see its first branch
+//the byte being received is dropped, the keyboard sends it again after the inhibit
+static void ps2_tx_start(uint8_t byte){
+	//odd parity
+	uint8_t parity=1;
+	for (uint8_t b=byte; b>0; b>>=1) parity^=b & 1;
+	GIMSK&=~(1<<INT0);
+	ps2_drive(KBD_CLK,0);
+	_delay_us(120);//at least 100 us
+	ps2_tx_frame=byte | ((uint16_t)parity<<8) | (1<<9);
+	ps2_tx_bit=0;
+	bitcount=11;
+	ps2_drive(KBD_DATA,0);
+	ps2_drive(KBD_CLK,1);
+	EIFR=1<<INTF0;
+	GIMSK|=1<<INT0;
+}
+
+//the keyboard never clocked the frame in, e.g. it is unplugged; the receiver waits for a start bit again
+static void ps2_tx_abort(void){
+	GIMSK&=~(1<<INT0);
+	ps2_tx_bit=PS2_TX_IDLE;
+	ps2_drive(KBD_DATA,1);
+	EIFR=1<<INTF0;
+	GIMSK|=1<<INT0;
+}
+
+//puts the next due command in kb_cmd, false when none is
+static bool kb_cmd_next(void){
+	kb_cmd_len=2;
+	if (kb_cmd_due & KB_CMD_SCAN_SET) {
+		kb_cmd[0]=PS2_CMD_SCAN_CODE_SET;
+		kb_cmd[1]=3;
+	}
+	else if (kb_cmd_due & KB_CMD_MAKE_BREAK) {
+		kb_cmd[0]=PS2_CMD_ALL_MAKE_BREAK;
+		kb_cmd_len=1;
+	}
+	else if (kb_cmd_due & KB_CMD_TYPEMATIC) {
+		kb_cmd[0]=PS2_CMD_SET_TYPEMATIC;
+		kb_cmd[1]=KB_TYPEMATIC;
+	}
+	else if (kb_cmd_due & KB_CMD_LEDS) {
+		kb_cmd[0]=PS2_CMD_SET_LEDS;
+		kb_cmd[1]=kb_leds;
+	}
+	else {
+		kb_cmd_len=0;
+		return false;
+	}
+	kb_cmd_due&=kb_cmd_due-1;//the lowest bit, the one just taken
+	kb_cmd_pos=0;
+	kb_cmd_tries=PS2_TX_TRIES;
+	return true;
+}
+
+//one step of sending the due commands; a byte is sent until the keyboard answers FA, PS2_TX_TRIES times at most,
+//and a command that fails is dropped with its argument
+static void kb_cmd_poll(void){
+	if (kb_cmd_busy) {
+		if (ps2_reply==PS2_REPLY_ACK) {
+			if (++kb_cmd_pos==kb_cmd_len) kb_cmd_len=0;
+			kb_cmd_tries=PS2_TX_TRIES;
+		}
+		else if ((ps2_reply==PS2_NO_KEY) && ((uint16_t)(timer_millis()-kb_cmd_time)<PS2_TX_MS+PS2_REPLY_MS)) return;
+		else {
+			//FE, or no answer to a frame the keyboard may not even have clocked in: send again
+			if (ps2_tx_bit!=PS2_TX_IDLE) ps2_tx_abort();
+			if (--kb_cmd_tries==0) kb_cmd_len=0;
+		}
+		kb_cmd_busy=false;
+	}
+	if ((kb_cmd_len==0) && !kb_cmd_next()) return;
+	watch_repeats=false;//the keyboard stops repeating on a command
+	ps2_reply=PS2_NO_KEY;
+	ps2_tx_start(kb_cmd[kb_cmd_pos]);
+	kb_cmd_time=timer_millis();
+	kb_cmd_busy=true;
+}
+
+//the LEDs go out with the next commands, what kb_leds holds then
+static void kb_set_leds(void){
+	kb_cmd_due|=KB_CMD_LEDS;
+}
+#else
+#define kb_set_leds()
+#endif
+
+//the Scroll Lock LED is on in the CP/M profile; pasted text is typed at the speed of the profile
+static void kb_profile_apply(void){
+#ifdef KB_COMMANDS
+	if (kb_profile==KB_PROFILE_CPM) kb_leds|=PS2_LED_SCROLL_LOCK;
+	else kb_leds&=~PS2_LED_SCROLL_LOCK;
+#endif
+#ifdef PASTE
+	paste_profile=(kb_profile==KB_PROFILE_CPM) ? MACRO_PROFILE_CPM : MACRO_PROFILE_BASIC;
+#endif
+}
+
+#ifdef KB_COMMANDS
+//slow typematic repeat and matching LEDs cut the traffic the receiver has to keep up with
+//called after power up and whenever the keyboard reports a passed self test; poll_kb() sends the commands
+void config_kb(void){
+#ifdef PS2_SCAN_CODE_SET3
+	//one make and one break code per key, no typematic repeat
+	kb_cmd_due|=KB_CMD_SCAN_SET | KB_CMD_MAKE_BREAK | KB_CMD_LEDS;
+#else
+	kb_cmd_due|=KB_CMD_TYPEMATIC | KB_CMD_LEDS;
+#endif
+}
+#endif
+
+//drains the received bytes; called from the main loop
+//each step waits for room in the switch queue rather than block in MT8808_queue_list()
+static bool kb_queue_room(void){
+	return MT8808_queue_free()>=KB_SEQ_ACTIONS;
+}
+
+void poll_kb(void){
+#ifdef KB_COMMANDS
+	kb_cmd_poll();
+#endif
+	if (!kb_queue_room()) return;
+	kb_watchdog();
+	if (!kb_queue_room()) return;
+	if (macro_step!=MACRO_STEP_IDLE) {
+		play_macro();
+		return;
+	}
+#ifdef PASTE
+#ifdef MACRO_RECORD
+	//pasted text waits for the end of a recording, the host is held off by XOFF meanwhile
+	if ((paste_count()>0) && (macro_rec!=MACRO_REC_ON)) {
+#else
+	if (paste_count()>0) {
+#endif
+		run_macro(NULL,0,paste_profile);
+		macro_pasting=true;
+		play_macro();
+		return;
+	}
+#endif
+	while ((ps2_buf_tail!=ps2_buf_head) && kb_queue_room()) {
+		ps2_scan_code=ps2_buf[ps2_buf_tail];
+		ps2_buf_tail=(ps2_buf_tail+1) & (PS2_BUF_SIZE-1);
+		watch_seen=timer_millis();
+		decode();
+	}
+	//a dropped byte may have been a break code; once the bytes before it are decoded nothing held can be trusted
+	if ((ps2_buf_overruns!=ps2_buf_overruns_seen) && (ps2_buf_tail==ps2_buf_head) && kb_queue_room()) {
+		ps2_buf_overruns_seen=ps2_buf_overruns;
+		kb_release_held();
+	}
+}
+
+
+//nothing received that poll_kb has not seen yet
+bool kb_idle(void){
+	return (ps2_buf_tail==ps2_buf_head) && (paste_count()==0);
+}
+
+//closes (state 1) or opens the crosspoints of one ZX key code: CAPS, SYM and the key itself, in one go
+void zx_key_switch(uint8_t zx_key, uint8_t state, uint8_t gap){
+	uint8_t actions[3];
+	uint8_t count=0;
+	uint8_t on=state ? MT8808_ACTION_ON : 0;
+	if ((zx_key & ZX_CAP_BIT)>0) actions[count++]=(ZX_KEY_CAPS & ADDR_MASK) | on;
+	if ((zx_key & ZX_SYM_BIT)>0) actions[count++]=(ZX_KEY_SYM & ADDR_MASK) | on;
+	actions[count++]=(zx_key & ADDR_MASK) | on;
+	MT8808_queue_list(actions,count,gap);
+}
+
+//closes the crosspoints of a ZX key, after tapping the E mode key if there is one
+static void zx_key_press(uint8_t zx_e_key, uint8_t zx_key, uint8_t gap){
+	uint8_t shared=0;
+	if (zx_e_key>0) {
+		//the first key is only tapped, the second one follows after a short delay
+		//CAPS and SYM needed by both keys are handed over without opening in between
+		shared=zx_e_key & zx_key & (ZX_CAP_BIT | ZX_SYM_BIT);
+		zx_key_switch(zx_e_key,1,gap);
+		zx_key_switch(zx_e_key & ~shared,0,E_MODE_DELAY);
+		gap=0;
+	}
+	//this condition is important to avoid processing a NO KEY value
+	if (zx_key>0) zx_key_switch(zx_key,1,gap);
+	if ((shared & ZX_CAP_BIT)>0) MT8808_queue(ZX_KEY_CAPS,0,0);
+	if ((shared & ZX_SYM_BIT)>0) MT8808_queue(ZX_KEY_SYM,0,0);
+}
+
+//all crosspoints open, nothing is held any more
+static void kb_reset_matrix(void){
+	kb_state=KB_PREFIX_NONE;
+#ifndef PS2_SCAN_CODE_SET3
+	kb_seq_pos=0;
+#endif
+	held_count=0;
+	watch_id=PS2_NO_KEY;
+#ifdef KB_REPEAT_SYNTH
+	repeat_up=false;
+#endif
+	MT8808_reset();
+}
+
+static uint8_t held_find(uint8_t id){
+	for (uint8_t i=0;i<held_count;i++) if (held_id[i]==id) return i;
+	return KB_HELD_KEYS;
+}
+
+//opens the crosspoints of a held key and drops it from the table
+static void held_release(uint8_t i){
+#ifdef KB_REPEAT_SYNTH
+	//let go between two repeats, its crosspoints are open already and nothing is left to repeat
+	if (repeat_up && (held_id[i]==watch_id)) repeat_up=false;
+	else
+#endif
+	zx_key_switch(held_zx[i],0,0);
+	telemetry_event(TELEMETRY_KEY_UP,held_zx[i]);
+	if (held_zx[i]==ZX_KEY_SYM) kb_state&=~KB_MOD_SYM;
+	else if (held_zx[i]==ZX_KEY_EXT_MODE) kb_state&=~KB_MOD_CTRL;
+	if (held_id[i]==watch_id) watch_id=PS2_NO_KEY;
+	held_count--;
+	for (;i<held_count;i++) {
+		held_id[i]=held_id[i+1];
+		held_zx[i]=held_zx[i+1];
+#ifdef KB_REPEAT_SYNTH
+		held_e[i]=held_e[i+1];
+#endif
+	}
+}
+
+//opens the keys the keyboard had down and forgets a half received code, their break codes never come
+//the mouse and a macro keep their crosspoints
+static void kb_release_held(void){
+	while (held_count>0) held_release(0);
+	kb_state=KB_PREFIX_NONE;
+	macro_key=PS2_NO_KEY;
+}
+
+//a held key that stopped repeating was let go and its break code was lost
+static void kb_watchdog(void){
+#ifndef PS2_SCAN_CODE_SET3
+	//the keyboard waits in ps2_buf while a macro or a paste plays, the timer starts again after it
+	if (macro_step!=MACRO_STEP_IDLE) watch_seen=timer_millis();
+	if ((watch_id!=PS2_NO_KEY) && watch_repeats && ((uint16_t)(timer_millis()-watch_seen)>KB_STUCK_TIMEOUT)) {
+		uint8_t i=held_find(watch_id);
+		if (i<KB_HELD_KEYS) {
+			held_release(i);
+			kb_forced_releases++;
+		}
+	}
+#endif
+#ifdef KB_REPEAT_SYNTH
+	//the HC2000 does not repeat by itself here, so the last pressed key is typed again
+	uint8_t i=held_find(watch_id);
+	if ((watch_id!=PS2_NO_KEY) && (i<KB_HELD_KEYS) && ((int16_t)(timer_millis()-repeat_due)>=0)) {
+		if (repeat_up) {
+			zx_key_press(held_e[i],held_zx[i],0);
+			repeat_due+=KB_REPEAT_RATE-KB_REPEAT_GAP;
+		}
+		else {
+			zx_key_switch(held_zx[i],0,0);
+			repeat_due+=KB_REPEAT_GAP;
+		}
+		repeat_up=!repeat_up;
+	}
+#endif
+}
+
+#ifdef MACRO_RECORD
+//CAPS, SYM and Ctrl only change what the other keys type
+static bool zx_modifier(uint8_t zx_key){
+	return (zx_key==ZX_KEY_CAPS) || (zx_key==ZX_KEY_SYM) || (zx_key==ZX_KEY_EXT_MODE);
+}
+
+//the CAPS and SYM bits the held modifier keys keep closed
+static uint8_t held_shifts(void){
+	uint8_t bits=0;
+	for (uint8_t i=0;i<held_count;i++) if (zx_modifier(held_zx[i])) bits|=held_zx[i] & (ZX_CAP_BIT | ZX_SYM_BIT);
+	return bits;
+}
+#endif
+
+//the held keys are found by the code the keyboard sent, bit 7 marking an E0 code
+static uint8_t kb_key_id(uint8_t scan_code, uint8_t ext){
+	return ext ? (scan_code | 0x80) : scan_code;
+}
+
+//the ZX key code paired with code in a table of pairs, PS2_NO_KEY when it has none
+static uint8_t kb_pair_find(const uint8_t (*pairs)[2], uint8_t count, uint8_t code){
+	for (uint8_t i=0; i<count; i++) {
+		if (pgm_read_byte(&pairs[i][0])==code) return pgm_read_byte(&pairs[i][1]);
+	}
+	return PS2_NO_KEY;
+}
+
+#define KB_PAIRS(table)	table,sizeof(table)/sizeof(table[0])
+
+//the one byte ZX key code the scan code stands for, see scan_code_lookup.h
+static uint8_t ps2_code_to_zx(uint8_t scan_code, uint8_t ext){
+	uint8_t zx_code=PS2_NO_KEY;
+#ifdef KB_CPM_PROFILE
+	if (kb_profile==KB_PROFILE_CPM) zx_code=kb_pair_find(KB_PAIRS(PS2_CPM_KEYS),kb_key_id(scan_code,ext));
+	if (zx_code!=PS2_NO_KEY) return zx_code;
+#endif
+#ifndef PS2_SCAN_CODE_SET3
+	if (ext) return kb_pair_find(KB_PAIRS(PS2_E0_KEYS),scan_code);
+#endif
+	//the keys of the layer the held modifiers pick, the rest type as in the base layer
+	if (kb_state & KB_MOD_CTRL) zx_code=kb_pair_find(KB_PAIRS(PS2_CTRL_KEYS),scan_code);
+	else if (kb_state & (KB_MOD_RSHIFT | KB_MOD_SYM)) zx_code=kb_pair_find(KB_PAIRS(PS2_SHIFTED_KEYS),scan_code);
+	if (zx_code!=PS2_NO_KEY) return zx_code;
+	return pgm_read_byte(&PS2_KEY_CODES[scan_code-PS2_CODE_FIRST]);
+}
+
+//the ZX key or keys of a one byte code; an E mode key comes in the high byte
+static uint16_t zx_expand(uint8_t zx_code){
+	if ((zx_code & ADDR_MASK)>=MT8808_CROSSPOINTS) return ZX_TWO_KEY(ZX_KEY_EXT_MODE,pgm_read_byte(&ZX_E_MODE_KEYS[(zx_code & ADDR_MASK)-MT8808_CROSSPOINTS]));
+	return zx_code;
+}
+
+//the release opens exactly what the press closed, whatever the modifiers are by now
+static void kb_key_release(uint8_t scan_code, uint8_t ext){
+	uint8_t i=held_find(kb_key_id(scan_code,ext));
+	//the first (E mode) key was already released right after it was pressed
+	//crosspoints are reference counted, so CAPS and SYM stay closed while other held keys use them
+	//a key missing from the table was already released by the watchdog
+	if (i<KB_HELD_KEYS) held_release(i);
+}
+
+static void kb_key_press(uint8_t scan_code, uint8_t ext){
 	uint16_t zx_key_code;
-	uint8_t mt_addr_switch[2];
+	uint8_t zx_code,zx_e_key,zx_key;
+	uint8_t id=kb_key_id(scan_code,ext);
 	
-	if (ps2_ext_key_code) zx_key_code=pgm_read_word(&(PS2_E0_EXT_CODE_TO_ZX[scan_code]));
-	else zx_key_code=pgm_read_word(&(PS2_CODE_TO_ZX[scan_code]));	
+	last_scan_code=scan_code;//for blinking the LED
 	
-	ps2_ext_key_code=false;
+	//typematic repeat, the key is still down
+	if (held_find(id)<KB_HELD_KEYS) return;
 	
-	last_scan_code=scan_code;//for blinking the LED
+	zx_code=ps2_code_to_zx(scan_code,ext);
+	zx_key_code=zx_expand(zx_code);
 	
 	//high byte goes first in processing
-	mt_addr_switch[0]=(uint8_t) (zx_key_code >> 8);
+	zx_e_key=(uint8_t) (zx_key_code >> 8);
 	//low byte goes second in processing
-	mt_addr_switch[1]=(uint8_t) zx_key_code;
+	zx_key=(uint8_t) zx_key_code;
+	
 
-	//handle 6,7,8,9,0 symbol exception
-	//this creates a problem with the underscore and single quote which are rewritten symbols with dedicated keys
-	//when dedicated keys are pressed the symbol shift zx_digit_symbol_shift is NOT true
-	void shift_digit_symbols(const uint8_t j){
-		if ((mt_addr_switch[j] & 56)==32) mt_addr_switch[j]|=2;//increase row by 2; 6-> H
-		else if ((mt_addr_switch[j] & 56)==16) mt_addr_switch[j]+=19;//8->B, increase row by 3 and column by 2
-		else mt_addr_switch[j]+=8; //0->9, 9->8, 7->6
+	//code of key that was pressed; activate switches
+	//the switches are queued so the E mode delay no longer blocks decoding
+#ifdef KB_REPEAT_SYNTH
+	//the key repeated so far stays down, only the new one repeats
+	if (repeat_up && (zx_key>0)) {
+		uint8_t i=held_find(watch_id);
+		if (i<KB_HELD_KEYS) zx_key_switch(held_zx[i],1,0);
+		repeat_up=false;
 	}
-	
+#endif
+	zx_key_press(zx_e_key,zx_key,0);
+	telemetry_event(TELEMETRY_KEY_DOWN,zx_key ? zx_key : zx_e_key);
+#ifdef MACRO_RECORD
+	//only live keys are recorded, not the ones a macro types, and the modifier keys only through the keys they shift
+	if ((macro_rec==MACRO_REC_ON) && (macro_step==MACRO_STEP_IDLE) && (zx_code>0) && !zx_modifier(zx_key)) {
+		//what the ZX saw: the key of the layer with the CAPS and SYM of the held modifier keys; E mode keys keep their one byte code
+		macro_record_key(zx_e_key ? zx_code : (zx_key | held_shifts()));
+	}
+#endif
+	if (zx_key>0) {
+		//SYM and Ctrl keys choose the layer for as long as they are held
+		if (zx_key==ZX_KEY_SYM) kb_state|=KB_MOD_SYM;
+		else if (zx_key==ZX_KEY_EXT_MODE) kb_state|=KB_MOD_CTRL;
+		if (held_count==KB_HELD_KEYS) held_release(0);//too many keys down, the oldest has to go
+		held_id[held_count]=id;
+		held_zx[held_count]=zx_key;
+#ifdef KB_REPEAT_SYNTH
+		held_e[held_count]=zx_e_key;
+		repeat_due=timer_millis()+KB_REPEAT_DELAY;
+		repeat_up=false;
+#endif
+		held_count++;
+		watch_id=id;
+		watch_repeats=true;
+	}
+#ifdef KB_COMMANDS
+	//the HC2000 toggles its caps lock on each press, the keyboard LED follows
+	if (id==PS2_KEY_CAPS_LOCK) {
+		kb_leds^=PS2_LED_CAPS_LOCK;
+		kb_set_leds();
+	}
+#endif
+}
 
-	if (state==PS2_STATE_KEY_RELEASED) {
-						
-		state=PS2_STATE_IDLE_WAIT_FOR_EVENT;		
-	
-		if (zx_digit_symbol_shifted && ((mt_addr_switch[1] & 7)==4)) {
-			shift_digit_symbols(1);
-			zx_digit_symbol_shifted=false;
-		}
-			
-		for (int8_t i=1; i>=0; i--) {						
-			//adding the conditions made the CS (Alt) work when pressed continuously 
-			//as opposed to pressing it and only working for one symbol, not keeping it down continuously
-			if ((mt_addr_switch[i] & ZX_CAP_BIT)>0)	MT8808_switch(ZX_KEY_CAPS,0);
-			if ((mt_addr_switch[i] & ZX_SYM_BIT)>0){
-				if (mt_addr_switch[i]==ZX_KEY_SYM) zx_digit_symbol_shift=false;
-				MT8808_switch(ZX_KEY_SYM,0);
+//macros play in steps from poll_kb() so INT0 and the timer stay live
+//keys typed meanwhile wait in the ring buffer, Esc aborts the macro
+//a macro is len ZX key codes, see macros.txt; they go straight to the switches, so the decoder state
+//and the held keys are left as they are
+void run_macro(const uint8_t * macro, uint8_t len, macro_profile_t profile){
+	macro_ptr=macro;
+	macro_pos=0;
+	macro_len=len;
+#if defined(MACRO_RECORD) && !defined(MACRO_MEM_EE)
+	macro_recorded=false;
+#endif
+#ifdef PASTE
+	macro_pasting=false;
+#endif
+	macro_profile=profile;
+	macro_step=MACRO_STEP_PRESS;
+	macro_code=PS2_NO_KEY;
+	macro_prev=PS2_NO_KEY;
+	macro_due=timer_millis()-UINT8_MAX;//longer ago than any gap, the first key goes at once
+	telemetry_event(TELEMETRY_MACRO,1);
+}
+
+#ifdef MACRO_RECORD
+//a slot that was never recorded, or whose recording was cut short, does not play
+static bool macro_slot_valid(uint8_t slot){
+	uint8_t len=eeprom_read_byte(&macro_slot[slot][MACRO_SLOT_LENGTH]);
+	uint8_t sum=len+eeprom_read_byte(&macro_slot[slot][MACRO_SLOT_CHECKSUM]);
+	if (len>MACRO_SLOT_KEYS) return false;
+	for (uint8_t i=0; i<len; i++) sum+=eeprom_read_byte(&macro_slot[slot][MACRO_SLOT_CODES+i]);
+	return sum==0;
+}
+
+static void run_recorded_macro(uint8_t slot){
+	if (!macro_slot_valid(slot)) return;
+	run_macro(&macro_slot[slot][MACRO_SLOT_CODES],eeprom_read_byte(&macro_slot[slot][MACRO_SLOT_LENGTH]),MACRO_PROFILE_SAFE);
+#ifndef MACRO_MEM_EE
+	macro_recorded=true;
+#endif
+}
+
+//keys typed from now on also go to EEPROM, written as they come so no RAM buffer is needed
+static void macro_record_start(uint8_t slot){
+	macro_rec_slot=slot;
+	macro_rec_sum=0;
+	macro_rec_len=0;
+	eeprom_update_byte(&macro_slot[slot][MACRO_SLOT_LENGTH],0xFF);
+	macro_rec=MACRO_REC_ON;
+	telemetry_event(TELEMETRY_MACRO,2);
+}
+
+static void macro_record_stop(void){
+	eeprom_update_byte(&macro_slot[macro_rec_slot][MACRO_SLOT_CHECKSUM],(uint8_t)(0-macro_rec_sum-macro_rec_len));
+	eeprom_update_byte(&macro_slot[macro_rec_slot][MACRO_SLOT_LENGTH],macro_rec_len);
+	macro_rec=MACRO_REC_OFF;
+	telemetry_event(TELEMETRY_MACRO,3);
+}
+
+static void macro_record_key(uint8_t zx_code){
+	eeprom_update_byte(&macro_slot[macro_rec_slot][MACRO_SLOT_CODES+macro_rec_len],zx_code);
+	macro_rec_sum+=zx_code;
+	//a full slot ends the recording
+	if (++macro_rec_len==MACRO_SLOT_KEYS) macro_record_stop();
+}
+#endif
+
+//F1 and F2 play the built in macros, F3 and F4 the recorded ones
+//F12 followed by F3 or F4 records into that slot, F12 again saves the recording; no macro plays meanwhile
+//Scroll Lock switches between the BASIC and CP/M keymap profiles
+static void macro_hotkey(uint8_t scan_code){
+#ifdef KB_CPM_PROFILE
+	if (scan_code==PS2_KEY_CODE_SCROLL_LOCK) {
+		kb_profile=(kb_profile==KB_PROFILE_CPM) ? KB_PROFILE_BASIC : KB_PROFILE_CPM;
+		eeprom_update_byte(&kb_profile_saved,kb_profile);
+		kb_profile_apply();
+		kb_set_leds();
+		return;
+	}
+#endif
+#ifdef MACRO_RECORD
+	if (scan_code==PS2_KEY_CODE_F12) {
+		if (macro_rec==MACRO_REC_ON) macro_record_stop();
+		else if (macro_rec==MACRO_REC_ARMED) macro_rec=MACRO_REC_OFF;
+		else macro_rec=MACRO_REC_ARMED;
+		return;
+	}
+	if (macro_rec==MACRO_REC_ON) return;
+#endif
+	if (scan_code==PS2_KEY_CODE_F1) run_macro(MACRO_CPM_RUN,sizeof(MACRO_CPM_RUN),MACRO_CPM_RUN_PROFILE);
+	else if (scan_code==PS2_KEY_CODE_F2) run_macro(MACRO_LOAD_FROM_DISK,sizeof(MACRO_LOAD_FROM_DISK),MACRO_LOAD_FROM_DISK_PROFILE);
+#ifdef MACRO_RECORD
+	else {
+		uint8_t slot=(scan_code==PS2_KEY_CODE_F3) ? 0 : 1;
+		if (macro_rec==MACRO_REC_ARMED) macro_record_start(slot);
+		else run_recorded_macro(slot);
+	}
+#endif
+}
+
+//ZX key code at pos; PS2_NO_KEY past the end
+static uint8_t read_macro_code(uint8_t pos){
+	if (pos>=macro_len) return PS2_NO_KEY;
+#ifndef MACRO_MEM_EE
+#ifdef MACRO_RECORD
+	if (!macro_recorded)
+#endif
+	return pgm_read_byte((PGM_P) &macro_ptr[pos]);
+#endif
+	return eeprom_read_byte(&macro_ptr[pos]);
+}
+
+static macro_key_class_t macro_key_class(uint8_t zx_code){
+	if (zx_code==macro_prev) return MACRO_KEY_REPEATED;
+	if ((zx_code & ADDR_MASK)>=MT8808_CROSSPOINTS) return MACRO_KEY_E_MODE;
+	if ((zx_code & (ZX_CAP_BIT | ZX_SYM_BIT))>0) return MACRO_KEY_SHIFTED;
+	return MACRO_KEY_PLAIN;
+}
+
+//ms to wait at a macro step for macro_code
+static uint8_t macro_timing(uint8_t step){
+	return pgm_read_byte(&MACRO_TIMING[macro_profile][macro_key_class(macro_code)][step]);
+}
+
+#ifdef PASTE
+//next key of the pasted text, control bytes are acted on as they come; PS2_NO_KEY until one is in
+static uint8_t paste_fetch(void){
+	while (paste_count()>0) {
+		uint8_t c=paste_peek(0);
+		uint8_t zx_code=PS2_NO_KEY;
+		if ((c>=PASTE_RAW) && (c<=PASTE_PAUSE)) {
+			uint8_t arg;
+			if (paste_count()<2) break;
+			arg=paste_peek(1);
+			paste_drop(2);
+			//only the E mode keys that exist
+			if (c==PASTE_RAW) {
+				if ((arg & ADDR_MASK)<ZX_E_MODE(sizeof(ZX_E_MODE_KEYS))) zx_code=arg;
 			}
-			if (mt_addr_switch[i]>0) MT8808_switch(mt_addr_switch[i],0);
+			else if (c==PASTE_PROFILE) {
+				if (arg<MACRO_PROFILES) paste_profile=macro_profile=(macro_profile_t)arg;
+			}
+			else macro_due=timer_millis()+(uint16_t)arg*10;
 		}
-	}
-	else {		
-		state=PS2_STATE_KEY_PRESSED;				
-		
-		if ((zx_digit_symbol_shift || zx_digit_symbol_shifted) && ((mt_addr_switch[1] & 7)==4)) {			
-			shift_digit_symbols(1);
-			zx_digit_symbol_shifted=true;
-		}		
-			
-		//code of key that was pressed; activate switches
-		for (int8_t i=0; i<=1; i++) {						
-			//this condition is important to avoid processing a NO KEY value
-			if (mt_addr_switch[i]>0) {
-				if ((mt_addr_switch[i] & ZX_CAP_BIT)>0) MT8808_switch(ZX_KEY_CAPS,1);
-				//else if (i==1) MT8808_switch(ZX_KEY_CAPS,0); //turning off the CAPS?
-				if ((mt_addr_switch[i] & ZX_SYM_BIT)>0)
-				{
-					//this refers to separate symbol shift key pressed
-					if (mt_addr_switch[i]==ZX_KEY_SYM) zx_digit_symbol_shift=true;
-					MT8808_switch(ZX_KEY_SYM,1);
-				}
-				MT8808_switch(mt_addr_switch[i],1);			
-				if (i==0){
-					//this is the first key so after a short delay
-					 _delay_ms(E_MODE_DELAY);
-					 //turn off the CAPS and SYM only if the next key has them off
-					if ((mt_addr_switch[1] & ZX_CAP_BIT)==0) MT8808_switch(ZX_KEY_CAPS,0);
-					if ((mt_addr_switch[1] & ZX_SYM_BIT)==0) MT8808_switch(ZX_KEY_SYM,0);					 
-				}
+		else {
+			paste_drop(1);
+			if (c=='\n') zx_code=ZX_KEY_CR;
+			else if (c=='\t') zx_code=ZX_KEY_TAB;
+			else if ((c>=PASTE_ASCII_FIRST) && (c<PASTE_ASCII_FIRST+sizeof(PASTE_ASCII))) {
+				zx_code=pgm_read_byte(&PASTE_ASCII[c-PASTE_ASCII_FIRST]);
 			}
 		}
-	}				
+		if (zx_code!=PS2_NO_KEY) return zx_code;
+	}
+	return PS2_NO_KEY;
 }
+#endif
 
-void run_macro(const uint8_t * macro){
-	cli();//disable global interrupts
-	uint8_t i=0;
-	uint8_t scode;
-	do {
-#ifdef MACRO_MEM_EE
-		scode=eeprom_read_byte(&macro[i]);
-#else
-		scode=pgm_read_byte((PGM_P) &macro[i]);
-#endif
-		if (scode==0) break;//otherwise there is a delay at the end of the macro
-		ps2_scan_code=scode;
-		decode();//press
-		_delay_ms(MACRO_TYPE_DELAY);		
-		ps2_scan_code=0xF0;
-		decode();//release
-		ps2_scan_code=scode;		
-		decode();
-		_delay_ms(2*MACRO_TYPE_DELAY);//twice the delay so switching to E and repetition have enough time
-		i++;
-	}
-	while (scode>0);
-	sei();//enable global interrupts	
+static uint8_t macro_fetch(void){
+#ifdef PASTE
+	if (macro_pasting) return paste_fetch();
+#endif
+	return read_macro_code(macro_pos++);
 }
 
-void decode(void){
-	if (ps2_scan_code==0xE0) {
-		if (ps2_ext_key_code){ //taking care of E0 after E0
-			ps2_ext_key_code=false;
-			MT8808_reset();
+//the E mode key, if any, was only tapped
+static void release_macro_key(void){
+	zx_key_switch((uint8_t)zx_expand(macro_code),0,0);
+}
+
+static void macro_stop(void){
+	macro_step=MACRO_STEP_IDLE;
+#ifdef PASTE
+	macro_pasting=false;
+#endif
+	telemetry_event(TELEMETRY_MACRO,0);
+}
+
+//looks for an Esc press among the buffered bytes and takes it out
+static bool macro_abort_requested(void){
+	uint8_t prev=PS2_NO_KEY;
+	for (uint8_t i=ps2_buf_tail; i!=ps2_buf_head; i=(i+1) & (PS2_BUF_SIZE-1)) {
+		if ((ps2_buf[i]==PS2_KEY_CODE_ESC) && (prev!=0xF0)) {
+			ps2_buf[i]=PS2_NO_KEY;
+			return true;
 		}
-		else ps2_ext_key_code=true;
+		prev=ps2_buf[i];
+	}
+	return false;
+}
+
+static void play_macro(void){
+	if (macro_abort_requested()) {
+		if (macro_step==MACRO_STEP_RELEASE) release_macro_key();
+#ifdef PASTE
+		//only what is buffered, a host that keeps sending is typed again
+		paste_drop(paste_count());
+#endif
+		macro_stop();
+		return;
 	}
-	else if (ps2_scan_code==0xF0) {		
-		state=PS2_STATE_KEY_RELEASED;
+	if (macro_step==MACRO_STEP_PRESS) {
+		uint16_t zx_key_code;
+		if (macro_code==PS2_NO_KEY) macro_code=macro_fetch();
+		if (macro_code==PS2_NO_KEY) {
+#ifdef PASTE
+			//a slow host is waited for, so a repeated key still gets its gap
+			if (macro_pasting) {
+				if ((int16_t)(timer_millis()-macro_due)<PASTE_IDLE_MS) return;
+				paste_drop(paste_count());//a control byte whose argument never came
+			}
+#endif
+			macro_stop();
+			return;
+		}
+		//the gap depends on the key before, a repeated one needs the longest
+		if ((int16_t)(timer_millis()-macro_due)<macro_timing(MACRO_GAP)) return;
+		zx_key_code=zx_expand(macro_code);
+		zx_key_press((uint8_t)(zx_key_code>>8),(uint8_t)zx_key_code,0);
+		macro_step=MACRO_STEP_RELEASE;
+		macro_due=timer_millis()+macro_timing(MACRO_HOLD);
 	}
-	//these are macros
-	else if (ps2_scan_code==PS2_KEY_CODE_F1){
-		run_macro(&PS2_MACRO_CPM_RUN[0]);
+	else if ((int16_t)(timer_millis()-macro_due)>=0) {
+		release_macro_key();
+		macro_prev=macro_code;
+		macro_code=PS2_NO_KEY;
+		macro_step=MACRO_STEP_PRESS;
 	}
-	else if (ps2_scan_code==PS2_KEY_CODE_F2){
-		run_macro(&PS2_MACRO_LOAD_FROM_DISK[0]);
+}
+
+#ifndef PS2_SCAN_CODE_SET3
+//one more byte of the sequence being matched; false when it does not fit, it is then decoded as usual
+static bool kb_sequence(uint8_t code){
+	if (pgm_read_byte(&KB_SEQUENCES[kb_seq][1+kb_seq_pos])!=code) {
+		kb_seq_pos=0;
+		return false;
 	}
-	else if (ps2_scan_code==PS2_KEY_CODE_RIGHT_SHIFT){
-		if (state==PS2_STATE_KEY_RELEASED){
-			ps2_RIGHT_SHIFT_key_PRESSED=false;		
-			state=PS2_STATE_IDLE_WAIT_FOR_EVENT;				
+	kb_seq_pos++;
+	if ((kb_seq_pos==KB_SEQ_BYTES) || (pgm_read_byte(&KB_SEQUENCES[kb_seq][1+kb_seq_pos])==PS2_NO_KEY)) {
+		uint8_t zx_key=pgm_read_byte(&KB_SEQUENCES[kb_seq][0]);
+		kb_seq_pos=0;
+		//held as long as the E mode key is tapped, longer than one ROM keyboard scan
+		if (zx_key!=PS2_NO_KEY) {
+			zx_key_switch(zx_key,1,0);
+			zx_key_switch(zx_key,0,E_MODE_DELAY);
 		}
-		else {
-			state=PS2_STATE_KEY_PRESSED;
-			ps2_RIGHT_SHIFT_key_PRESSED=true;
+	}
+	return true;
+}
+#endif
+
+static kb_byte_class_t kb_byte_class(uint8_t code){
+	if (code==PS2_NO_KEY) return KB_BYTE_NONE;
+#ifndef PS2_SCAN_CODE_SET3
+	if (code==0xE0) return KB_BYTE_E0;
+#endif
+	if (code==0xF0) return KB_BYTE_F0;
+	if (code==PS2_REPLY_BAT_OK) return KB_BYTE_BAT;
+#ifndef PS2_SCAN_CODE_SET3
+	if (code==0xE1) return KB_BYTE_E1;
+#endif
+	if (code==PS2_KEY_CODE_RIGHT_SHIFT) return KB_BYTE_RSHIFT;
+	if ((code==PS2_KEY_CODE_F1) || (code==PS2_KEY_CODE_F2)) return KB_BYTE_HOTKEY;
+#ifdef KB_CPM_PROFILE
+	if (code==PS2_KEY_CODE_SCROLL_LOCK) return KB_BYTE_HOTKEY;
+#endif
+#ifdef MACRO_RECORD
+	if ((code==PS2_KEY_CODE_F3) || (code==PS2_KEY_CODE_F4) || (code==PS2_KEY_CODE_F12)) return KB_BYTE_HOTKEY;
+#endif
+	if ((code>=PS2_CODE_FIRST) && (code<=PS2_CODE_LAST)) return KB_BYTE_KEY;
+	return KB_BYTE_OTHER;
+}
+
+//one step of the decoder: the byte class and the prefix pick the action and the next prefix from
+//KB_TRANSITIONS, so every byte costs the same and no path can leave a prefix pending
+void decode(void){
+	uint8_t code=ps2_scan_code;
+#ifndef PS2_SCAN_CODE_SET3
+	if ((kb_seq_pos>0) && kb_sequence(code)) return;
+#endif
+	uint8_t prefix=kb_state & KB_PREFIX_MASK;
+	uint8_t entry=pgm_read_byte(&KB_TRANSITIONS[prefix][kb_byte_class(code)]);
+	kb_action_t action=KB_GO_ACTION(entry);
+	kb_state=(kb_state & ~KB_PREFIX_MASK) | (entry & KB_PREFIX_MASK);
+	//the keyboard repeats the last key pressed, whether the adapter holds it or not
+	if ((action>=KB_ACT_PRESS) && (kb_key_id(code,prefix & KB_PREFIX_EXT)!=watch_id)) watch_repeats=false;
+	if (action==KB_ACT_PRESS) kb_key_press(code,prefix & KB_PREFIX_EXT);
+	else if (action==KB_ACT_RELEASE) kb_key_release(code,prefix & KB_PREFIX_EXT);
+	else if (action==KB_ACT_RSHIFT_DOWN) kb_state|=KB_MOD_RSHIFT;
+	else if (action==KB_ACT_RSHIFT_UP) kb_state&=~KB_MOD_RSHIFT;
+	else if (action==KB_ACT_HOTKEY_DOWN) {
+		//typematic repeats of the held key do not restart the macro
+		if (code!=macro_key) {
+			macro_key=code;
+			macro_hotkey(code);
 		}
 	}
-	//regular codes
-	else if ((ps2_scan_code>12) && (ps2_scan_code<128)) { //132 scan codes, and 125 extended scan codes				
-		/*	dec 1
-				,	65	<	64
-				.	73	>	72								
-				'	82	"	81
-				[	84	{	83
-			inc 1
-				-	78	_	79										
-				=	85	+	86
-				]	91	}	92
-				\	93	|	94
-
-			dec 3
-				/	74	?	71
-			inc 4
-				;	76	:	80				
-		*/
-		//rewriting shifted symbol codes
-		if (ps2_RIGHT_SHIFT_key_PRESSED || ps2_RIGHT_SHIFTED_symbols) {
-			if ((ps2_scan_code==65) || (ps2_scan_code==73) || (ps2_scan_code==82)|| (ps2_scan_code==84)) ps2_scan_code--;
-			else if ((ps2_scan_code==78) || (ps2_scan_code==85) || (ps2_scan_code==91)|| (ps2_scan_code==93)) ps2_scan_code++;
-			else if (ps2_scan_code==74) ps2_scan_code-=3;
-			else if (ps2_scan_code==76) ps2_scan_code+=4;
-			if (state==PS2_STATE_KEY_RELEASED) ps2_RIGHT_SHIFTED_symbols=false;
-			else ps2_RIGHT_SHIFTED_symbols=true;
+	else if (action==KB_ACT_HOTKEY_UP) macro_key=PS2_NO_KEY;
+	else if (action==KB_ACT_BAT) {
+		//keyboard plugged in or reset, it came up with its default settings and sends no break codes
+		kb_release_held();
+		config_kb();
+	}
+#ifndef PS2_SCAN_CODE_SET3
+	else if (action==KB_ACT_SEQUENCE) {
+		for (kb_seq=0; kb_seq<sizeof(KB_SEQUENCES)/sizeof(KB_SEQUENCES[0]); kb_seq++) {
+			if (pgm_read_byte(&KB_SEQUENCES[kb_seq][1])==code) {
+				kb_seq_pos=1;
+				break;
+			}
 		}
-		ps2_scan_code_to_mt8808_switch(ps2_scan_code);		
-	}	
-	else { 
-		ps2_ext_key_code=false;
-		//init_kb();
-		MT8808_reset();
-	}	
+	}
+#endif
 }
@@ -26,13 +26,66 @@
 #define PS2_KB_H_
 
 #include <inttypes.h>
-#include <avr/pgmspace.h>
+#include <stdbool.h>
+#include <config.h>
 
-volatile uint8_t last_scan_code;
+//held keys are switched once and left closed, the HC2000 ROM repeats them by itself
+//define to have the adapter type the last held key again instead, for software that does not
+//#define KB_REPEAT_SYNTH
+#define KB_REPEAT_DELAY 500 //ms from the press to the first repeat
+#define KB_REPEAT_RATE 100 //ms between repeats
+#define KB_REPEAT_GAP 30 //ms the key stays open so the ROM sees it released
+
+//keyboard commands and replies
+#define PS2_CMD_SET_LEDS		0xED
+#define PS2_CMD_SCAN_CODE_SET	0xF0
+#define PS2_CMD_SET_TYPEMATIC	0xF3
+#define PS2_CMD_ALL_MAKE_BREAK	0xF8
+#define PS2_REPLY_BAT_OK		0xAA
+#define PS2_REPLY_ACK			0xFA
+#define PS2_REPLY_RESEND		0xFE
+#define PS2_LED_SCROLL_LOCK		0x01
+#define PS2_LED_CAPS_LOCK		0x04
+
+#define KB_TYPEMATIC 0x34 //500 ms delay, 5 repeats per second
+
+//timing shared by the keyboard and mouse channels
+#define PS2_EDGE_TIMEOUT TIMER_US(200) //falling clock edges are 60..100 us apart inside a frame
+#define PS2_TX_TRIES 3
+#define PS2_REPLY_MS 20
+
+//macro typing speeds, see MACRO_TIMING
+typedef enum MACRO_PROFILE{
+	MACRO_PROFILE_SAFE,		//the old fixed 50 ms press and 100 ms gap, for software that scans slowly
+	MACRO_PROFILE_BASIC,	//the ROM editor in K/L mode
+	MACRO_PROFILE_CPM,
+	MACRO_PROFILES
+} macro_profile_t;
+
+//keymap profiles; Scroll Lock switches between them and the choice is kept in EEPROM
+typedef enum KB_PROFILE{
+	KB_PROFILE_BASIC,		//Ctrl taps E mode before it holds CAPS+SYM, for the keywords of the ROM editor
+	KB_PROFILE_CPM,			//Ctrl and the cursor keys are plain CAPS+SYM chords, see PS2_CPM_KEYS
+	KB_PROFILES
+} kb_profile_t;
+
+extern volatile uint8_t last_scan_code;
+extern volatile uint8_t ps2_frame_errors;
+extern volatile uint8_t ps2_buf_overruns;
+extern volatile uint8_t kb_forced_releases;
 
 void init_kb(void);
+void poll_kb(void);
+bool kb_idle(void);
 void decode(void);
-void run_macro(const uint8_t * macro);
+#ifdef KB_COMMANDS
+void config_kb(void);
+#else
+#define config_kb()
+#endif
+bool ps2_send_frame(uint8_t clk, uint8_t data, uint8_t byte);
+void zx_key_switch(uint8_t zx_key, uint8_t state, uint8_t gap);
+void run_macro(const uint8_t * macro, uint8_t len, macro_profile_t profile);
 
 
 #endif /* PS2_KB_H_ */
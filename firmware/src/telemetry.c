@@ -0,0 +1,124 @@
+/*
+ * telemetry.c
+ *
+ * Created: 17/10/2026 3:02:14 PM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+//timer 0 clocks the bits out from its compare interrupt; records queue in a ring buffer that any
+//interrupt can add to, and the interrupt is off whenever there is nothing left to send
+
+#include <config.h>
+
+#ifdef TELEMETRY
+
+#include <inttypes.h>
+#include <hal.h>
+#include <pins.h>
+#include <telemetry.h>
+
+#define TELEMETRY_BIT_TICKS	(F_CPU/8/TELEMETRY_BAUD) //timer 0 counts at clk/8
+
+_Static_assert((TELEMETRY_BIT_TICKS>=16) && (TELEMETRY_BIT_TICKS<=256),"TELEMETRY_BAUD does not fit timer 0 at this F_CPU");
+
+static volatile uint8_t tx_buf[TELEMETRY_BUF_SIZE];
+static volatile uint8_t tx_head,tx_tail;
+static uint8_t tx_shift;
+static uint8_t tx_bit;		//0 before the start bit, 1..8 data, 9 stop
+static uint8_t tx_dropped;
+
+
+void init_telemetry(void){
+	PORTD|=1<<TELEMETRY_TX;			//idle high
+	DDRD|=1<<TELEMETRY_TX;
+	TCCR0A=1<<WGM01;				//CTC, cleared at OCR0A
+	TCCR0B=1<<CS01;					//clk/8
+	OCR0A=TELEMETRY_BIT_TICKS-1;
+	tx_head=0;
+	tx_tail=0;
+	tx_bit=0;
+	tx_dropped=0;
+}
+
+
+static void tx_put(uint8_t byte){
+	tx_buf[tx_head]=byte;
+	tx_head=(tx_head+1) & (TELEMETRY_BUF_SIZE-1);
+}
+
+
+static void tx_put_record(uint8_t type, uint8_t value, uint16_t time){
+	tx_put(type);
+	tx_put(value);
+	tx_put((uint8_t)time);
+	tx_put((uint8_t)(time>>8));
+}
+
+
+//queues one record; when the buffer is full the record is only counted and reported later
+void telemetry_event(uint8_t type, uint8_t value){
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		uint16_t now=TCNT1;
+		uint8_t room=(tx_tail-tx_head-1) & (TELEMETRY_BUF_SIZE-1);
+		if (tx_dropped && (room>=2*TELEMETRY_RECORD_SIZE)) {
+			tx_put_record(TELEMETRY_DROPPED,tx_dropped,now);
+			tx_dropped=0;
+			room-=TELEMETRY_RECORD_SIZE;
+		}
+		if (tx_dropped || (room<TELEMETRY_RECORD_SIZE)) {
+			if (tx_dropped<0xff) tx_dropped++;
+		}
+		else {
+			tx_put_record(type,value,now);
+			//start the bit clock from the stop level, the first compare sends the start bit
+			if (!(TIMSK & (1<<OCIE0A))) {
+				TCNT0=0;
+				TIFR=1<<OCF0A;
+				TIMSK|=1<<OCIE0A;
+			}
+		}
+	}
+}
+
+
+ISR (TIMER0_COMPA_vect) {
+	if (tx_bit==0) {
+		if (tx_head==tx_tail) {
+			TIMSK&=~(1<<OCIE0A);
+			return;
+		}
+		tx_shift=tx_buf[tx_tail];
+		tx_tail=(tx_tail+1) & (TELEMETRY_BUF_SIZE-1);
+		PORTD&=~(1<<TELEMETRY_TX);	//start bit
+		tx_bit=1;
+	}
+	else if (tx_bit<9) {
+		//least significant bit first
+		if (tx_shift & 1) PORTD|=1<<TELEMETRY_TX;
+		else PORTD&=~(1<<TELEMETRY_TX);
+		tx_shift>>=1;
+		tx_bit++;
+	}
+	else {
+		PORTD|=1<<TELEMETRY_TX;		//stop bit
+		tx_bit=0;
+	}
+}
+
+#endif
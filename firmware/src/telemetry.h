@@ -0,0 +1,59 @@
+/*
+ * telemetry.h
+ *
+ * Created: 17/10/2026 3:02:51 PM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+//optional event log sent out of UNUSED_IO by a transmit only software UART, 8N1
+//each record is 4 bytes: type, value, then TCNT1 low and high byte at the time of the event
+//tools/telemetry.py turns a capture into a readable log and latency histograms
+
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <inttypes.h>
+#include <config.h>
+
+//record types; the high nibble helps the decoder find the record boundaries
+#define TELEMETRY_RX_BYTE		0xA1	//byte received from the keyboard
+#define TELEMETRY_FRAME_ERROR	0xA2	//value is the low byte of ps2_frame_errors
+#define TELEMETRY_KEY_DOWN		0xA3	//ZX key code closed for a key press
+#define TELEMETRY_KEY_UP		0xA4	//ZX key code opened again
+#define TELEMETRY_SWITCH		0xA5	//MT8808 strobe, address plus MT8808_ACTION_ON
+#define TELEMETRY_RESET			0xA6	//MT8808 reset, all switches open
+#define TELEMETRY_MACRO			0xA7	//1 when a macro starts, 0 when it stops, 2 and 3 for a recording
+#define TELEMETRY_DROPPED		0xA8	//records lost to a full buffer since the last one sent
+
+#define TELEMETRY_RECORD_SIZE	4
+
+#ifdef TELEMETRY
+
+void init_telemetry(void);
+void telemetry_event(uint8_t type, uint8_t value);
+
+#else
+
+#define init_telemetry()
+#define telemetry_event(type,value)
+
+#endif
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,59 @@
+/*
+ * timer.c
+ *
+ * Created: 17/10/2026 9:01:47 AM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+#include <inttypes.h>
+#include <hal.h>
+#include <timer.h>
+#include <MT8808.h>
+#include <led.h>
+
+volatile static uint16_t timer_ms;//wraps every 65 s, compare with signed differences
+
+void init_timer(void){
+	TCCR1A=0;								//normal mode, the counter is never cleared
+	TCCR1B=(1<<CS11) | (1<<CS10);			//clk/64
+	OCR1A=TCNT1+TIMER_TICK;
+	TIMSK|=1<<OCIE1A;						//compare A interrupt
+}
+
+
+//interrupts are back on while the queued switches are written, so a long batch cannot delay the PS/2
+//clock edges past the half period their data bits are valid for
+ISR (TIMER1_COMPA_vect) {
+	//moving the compare point keeps TCNT1 free running; done first, a 16 bit register goes through the
+	//TEMP register shared with the TCNT1 and ICR1 reads of the other handlers
+	OCR1A+=TIMER_TICK;
+	sei();
+	timer_ms++;
+	MT8808_tick();
+	led_tick();
+}
+
+
+uint16_t timer_millis(void){
+	uint16_t ms;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		ms=timer_ms;
+	}
+	return ms;
+}
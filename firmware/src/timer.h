@@ -0,0 +1,39 @@
+/*
+ * timer.h
+ *
+ * Created: 17/10/2026 9:02:11 AM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include <hal.h> //F_CPU
+#include <inttypes.h>
+
+//timer 1 runs free with a /64 prescaler, compare A fires every ms
+#define TIMER_PRESCALER	64
+#define TIMER_TICK		(F_CPU/TIMER_PRESCALER/1000)
+#define TIMER_US(us)	((uint16_t)((F_CPU/TIMER_PRESCALER)*(us)/1000000UL)) //TCNT1 counts
+
+void init_timer(void);
+uint16_t timer_millis(void);
+
+#endif /* TIMER_H_ */
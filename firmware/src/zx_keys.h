@@ -0,0 +1,188 @@
+/*
+ * zx_keys.h
+ *
+ * Created: 17/10/2026 6:41:19 PM
+ *  Author: sphome
+
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+
+ */ 
+
+//ZX key codes, one byte per key: bit 7 SYM, bit 6 CAPS, then the matrix address; only defines,
+//so every module that switches keys can include it, the tables built from them are in scan_code_lookup.h
+
+
+#ifndef ZX_KEYS_H_
+#define ZX_KEYS_H_
+
+#include <MT8808.h> //MT8808_CROSSPOINTS
+
+#define ZX_SYM_BIT 0x80
+#define ZX_CAP_BIT 0x40
+//,e_mode,g_mode
+
+#define ZX_KEY(row,col) (0x00 | (col << 3) | row)
+
+#define ZX_ONE_KEY(k)		(k	| 0x0000	)
+#define ZX_TWO_KEY(k1,k2)	(k2	| (k1 << 8)	)
+#define ZX_CAP(k)			(k	| ZX_CAP_BIT)
+#define ZX_SYM(k)			(k	| ZX_SYM_BIT)
+
+
+/* ZX spectrum key matrix
+				
+		TD0		TD1		TD2		TD3		TD4		AX[0..2]			EX5		EX6		EX7
+ A8		CAPS	Z		X		C		V		0, 0, 0		+0
+ A9		A		S		D		F		G		1, 0, 0		+1
+A10		Q		W		E		R		T		0, 1, 0		+2
+A11		1		2		3		4		5		1, 1, 0		+3
+A12		0		9		8		7		6		0, 0, 1		+4
+A13		P		O		I		U		Y		1, 0, 1		+5		
+A14		CR		L		K		J		H		0, 1, 1		+6
+A15		SP		SYM		M		N		B		1, 1, 1		+7
+
+		+0		+1		+2		+3		+4							+5		+6		+7
+AY0		0		1		0		1		0							1		0		1
+AY1		0		0		1		1		0							0		1		1
+AY2		0		0		0		0		1							1		1		1
+	
+if AY[0..2] is 5, 6 or 7, then special handling is signaled				
+*/
+
+#define ZX_KEY_CAPS		ZX_ONE_KEY(ZX_CAP(ZX_KEY(0,0))) //must OR with cap bit
+#define ZX_KEY_Z		ZX_ONE_KEY(ZX_KEY(0,1))
+#define ZX_KEY_X		ZX_ONE_KEY(ZX_KEY(0,2))
+#define ZX_KEY_C		ZX_ONE_KEY(ZX_KEY(0,3))
+#define ZX_KEY_V		ZX_ONE_KEY(ZX_KEY(0,4))
+											 
+#define ZX_KEY_A		ZX_ONE_KEY(ZX_KEY(1,0))
+#define ZX_KEY_S		ZX_ONE_KEY(ZX_KEY(1,1))
+#define ZX_KEY_D		ZX_ONE_KEY(ZX_KEY(1,2))
+#define ZX_KEY_F		ZX_ONE_KEY(ZX_KEY(1,3))
+#define ZX_KEY_G		ZX_ONE_KEY(ZX_KEY(1,4))
+											 
+#define ZX_KEY_Q		ZX_ONE_KEY(ZX_KEY(2,0))
+#define ZX_KEY_W		ZX_ONE_KEY(ZX_KEY(2,1))
+#define ZX_KEY_E		ZX_ONE_KEY(ZX_KEY(2,2))
+#define ZX_KEY_R		ZX_ONE_KEY(ZX_KEY(2,3))
+#define ZX_KEY_T		ZX_ONE_KEY(ZX_KEY(2,4))
+											 
+#define ZX_KEY_1		ZX_ONE_KEY(ZX_KEY(3,0))
+#define ZX_KEY_2		ZX_ONE_KEY(ZX_KEY(3,1))
+#define ZX_KEY_3		ZX_ONE_KEY(ZX_KEY(3,2))
+#define ZX_KEY_4		ZX_ONE_KEY(ZX_KEY(3,3))
+#define ZX_KEY_5		ZX_ONE_KEY(ZX_KEY(3,4))
+						
+#define ZX_KEY_0		ZX_ONE_KEY(ZX_KEY(4,0))
+#define ZX_KEY_9		ZX_ONE_KEY(ZX_KEY(4,1))
+#define ZX_KEY_8		ZX_ONE_KEY(ZX_KEY(4,2))
+#define ZX_KEY_7		ZX_ONE_KEY(ZX_KEY(4,3))
+#define ZX_KEY_6		ZX_ONE_KEY(ZX_KEY(4,4))
+						
+#define ZX_KEY_P		ZX_ONE_KEY(ZX_KEY(5,0))
+#define ZX_KEY_O		ZX_ONE_KEY(ZX_KEY(5,1))
+#define ZX_KEY_I		ZX_ONE_KEY(ZX_KEY(5,2))
+#define ZX_KEY_U		ZX_ONE_KEY(ZX_KEY(5,3))
+#define ZX_KEY_Y		ZX_ONE_KEY(ZX_KEY(5,4))
+						
+#define ZX_KEY_CR		ZX_ONE_KEY(ZX_KEY(6,0))
+#define ZX_KEY_L		ZX_ONE_KEY(ZX_KEY(6,1))
+#define ZX_KEY_K		ZX_ONE_KEY(ZX_KEY(6,2))
+#define ZX_KEY_J		ZX_ONE_KEY(ZX_KEY(6,3))
+#define ZX_KEY_H		ZX_ONE_KEY(ZX_KEY(6,4))
+						
+#define ZX_KEY_SP		ZX_ONE_KEY(ZX_KEY(7,0))
+#define ZX_KEY_SYM		ZX_ONE_KEY(ZX_SYM(ZX_KEY(7,1))) //I OR the SYM bit
+#define ZX_KEY_M		ZX_ONE_KEY(ZX_KEY(7,2))
+#define ZX_KEY_N		ZX_ONE_KEY(ZX_KEY(7,3))
+#define ZX_KEY_B		ZX_ONE_KEY(ZX_KEY(7,4))
+						
+//CAPS+key				
+#define ZX_KEY_EDIT		ZX_ONE_KEY(ZX_CAP(ZX_KEY_1)) //same as escape 
+#define ZX_KEY_ESCAPE	ZX_ONE_KEY(ZX_CAP(ZX_KEY_1)) //same as edit
+#define ZX_KEY_BREAK	ZX_ONE_KEY(ZX_CAP(ZX_KEY_SP))
+
+#define ZX_KEY_CAPS_LCK	ZX_ONE_KEY(ZX_CAP(ZX_KEY_2)) //
+#define ZX_KEY_NORM_VID	ZX_ONE_KEY(ZX_CAP(ZX_KEY_3))
+#define ZX_KEY_INV_VID	ZX_ONE_KEY(ZX_CAP(ZX_KEY_4))
+#define ZX_KEY_LEFT		ZX_ONE_KEY(ZX_CAP(ZX_KEY_5)) //
+						
+#define ZX_KEY_DEL		ZX_ONE_KEY(ZX_CAP(ZX_KEY_0)) //
+#define ZX_KEY_GR_MODE	ZX_ONE_KEY(ZX_CAP(ZX_KEY_9)) //
+#define ZX_KEY_RIGHT	ZX_ONE_KEY(ZX_CAP(ZX_KEY_8)) //
+#define ZX_KEY_UP		ZX_ONE_KEY(ZX_CAP(ZX_KEY_7)) //
+#define ZX_KEY_DOWN		ZX_ONE_KEY(ZX_CAP(ZX_KEY_6)) //
+
+//SYM + key
+#define ZX_KEY_EXT_MODE ZX_ONE_KEY(ZX_SYM(ZX_KEY_CAPS)) //CAP+SYM
+#define ZX_KEY_COLON	ZX_ONE_KEY(ZX_SYM(ZX_KEY_Z))
+#define ZX_KEY_POUND	ZX_ONE_KEY(ZX_SYM(ZX_KEY_X))
+#define ZX_KEY_QMARK	ZX_ONE_KEY(ZX_SYM(ZX_KEY_C))
+#define ZX_KEY_SLASH	ZX_ONE_KEY(ZX_SYM(ZX_KEY_V))
+#define ZX_KEY_STAR		ZX_ONE_KEY(ZX_SYM(ZX_KEY_B))
+#define ZX_KEY_COMMA	ZX_ONE_KEY(ZX_SYM(ZX_KEY_N))
+#define ZX_KEY_PERIOD	ZX_ONE_KEY(ZX_SYM(ZX_KEY_M))
+
+#define ZX_KEY_HAT		ZX_ONE_KEY(ZX_SYM(ZX_KEY_H))
+#define ZX_KEY_MINUS	ZX_ONE_KEY(ZX_SYM(ZX_KEY_J))
+#define ZX_KEY_PLUS		ZX_ONE_KEY(ZX_SYM(ZX_KEY_K))
+#define ZX_KEY_EQUAL	ZX_ONE_KEY(ZX_SYM(ZX_KEY_L))
+
+#define ZX_KEY_LTEQ		ZX_ONE_KEY(ZX_SYM(ZX_KEY_Q))
+#define ZX_KEY_DIFF		ZX_ONE_KEY(ZX_SYM(ZX_KEY_W))
+#define ZX_KEY_GTEQ		ZX_ONE_KEY(ZX_SYM(ZX_KEY_E))
+#define ZX_KEY_ANG_BRACKET_OPEN		ZX_ONE_KEY(ZX_SYM(ZX_KEY_R))
+#define ZX_KEY_ANG_BRACKET_CLOSE	ZX_ONE_KEY(ZX_SYM(ZX_KEY_T))
+
+#define ZX_KEY_SEMICOLON	ZX_ONE_KEY(ZX_SYM(ZX_KEY_O))
+#define ZX_KEY_DOUBLE_QUOTE	ZX_ONE_KEY(ZX_SYM(ZX_KEY_P))
+
+#define ZX_KEY_EXCL					ZX_ONE_KEY(ZX_SYM(ZX_KEY_1))
+#define ZX_KEY_AT					ZX_ONE_KEY(ZX_SYM(ZX_KEY_2))
+#define ZX_KEY_HASH					ZX_ONE_KEY(ZX_SYM(ZX_KEY_3))
+#define ZX_KEY_DOLLAR				ZX_ONE_KEY(ZX_SYM(ZX_KEY_4))
+#define ZX_KEY_PERCENT				ZX_ONE_KEY(ZX_SYM(ZX_KEY_5))
+#define ZX_KEY_AMPER				ZX_ONE_KEY(ZX_SYM(ZX_KEY_6))
+#define ZX_KEY_SINGLE_QUOTE			ZX_ONE_KEY(ZX_SYM(ZX_KEY_7))
+#define ZX_KEY_ROUND_BRACKET_OPEN	ZX_ONE_KEY(ZX_SYM(ZX_KEY_8))
+#define ZX_KEY_ROUND_BRACKET_CLOSE	ZX_ONE_KEY(ZX_SYM(ZX_KEY_9))
+#define ZX_KEY_UNDERSCORE			ZX_ONE_KEY(ZX_SYM(ZX_KEY_0))
+
+//E mode + key
+//one byte codes past the matrix crosspoints; ZX_E_MODE_KEYS holds the key typed after E mode
+#define ZX_E_MODE(i)	(MT8808_CROSSPOINTS+(i))
+
+#define ZX_KEY_TAB					ZX_E_MODE(0)
+#define ZX_KEY_USR					ZX_E_MODE(1)
+
+//E mode + SYM + key
+#define ZX_KEY_SQ_BRACKET_OPEN		ZX_E_MODE(2)
+#define ZX_KEY_SQ_BRACKET_CLOSE		ZX_E_MODE(3)
+#define ZX_KEY_COPYRIGHT			ZX_E_MODE(4)
+
+#define ZX_KEY_TILDE				ZX_E_MODE(5)
+#define ZX_KEY_PIPE					ZX_E_MODE(6)
+#define ZX_KEY_BACKSLASH			ZX_E_MODE(7)
+#define ZX_KEY_CURL_BRACKET_OPEN	ZX_E_MODE(8)
+#define ZX_KEY_CURL_BRACKET_CLOSE	ZX_E_MODE(9)
+
+#define ZX_KEY_CAT					ZX_E_MODE(10)
+
+//E mode + CAPS+SYM held: Ctrl of the BASIC profile, the key typed while it is held completes the E mode
+//sequence; the CP/M profile closes CAPS+SYM straight away, ZX_KEY_EXT_MODE, see PS2_CPM_KEYS
+#define ZX_KEY_CTRL					ZX_E_MODE(11)
+
+#endif /* ZX_KEYS_H_ */
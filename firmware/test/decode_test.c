@@ -0,0 +1,129 @@
+/*
+ * decode_test.c
+ *
+ * Created: 17/10/2026 11:05:40 PM
+ *  Author: sphome
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+/*
+ Decoder walk, see "make test" in firmware/Makefile.
+
+ In every profile built, every state of KB_TRANSITIONS the scan code set can reach (prefix, with and without
+ right shift and a SYM key held) gets every byte, then the releases a keyboard would send after it.
+ Once macros and the switch queue are done no switch may be left closed and the decoder must be back
+ in its idle state. Set 3 has no E0 prefix, its rows are not walked.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <ps2_kb.c>
+
+#define WALK_MODS	4	//bit 0 right shift down, bit 1 SYM held
+#ifdef KB_CPM_PROFILE
+#define WALK_PROFILES	KB_PROFILES
+#else
+#define WALK_PROFILES	1	//BASIC only
+#endif
+
+static uint8_t closed[64];
+static uint32_t resets_seen;
+static unsigned cases,failures;
+
+//a switch reset opens every switch
+static void closed_sync(void){
+	if (hal_host_reset_count==resets_seen) return;
+	memset(closed,0,sizeof(closed));
+	resets_seen=hal_host_reset_count;
+}
+
+static void switch_hook(uint32_t time_us, uint8_t addr, uint8_t state){
+	(void)time_us;
+	closed_sync();
+	closed[addr]=state;
+}
+
+static void run_ms(uint32_t ms){
+	while (ms--) {
+		hal_host_advance_us(1000);
+		poll_kb();
+	}
+}
+
+static void send(uint8_t byte){
+	hal_host_ps2_send(byte);
+	poll_kb();
+	run_ms(2);
+}
+
+static void tap(uint8_t code){
+	send(code);
+	send(0xF0);
+	send(code);
+}
+
+static void walk(uint8_t profile, uint8_t mods, uint8_t prefix, uint8_t code){
+	init_kb();
+	run_ms(50);
+	if (kb_profile!=profile) tap(PS2_KEY_CODE_SCROLL_LOCK);
+	closed_sync();
+	if (mods&1) send(PS2_KEY_CODE_RIGHT_SHIFT);
+	if (mods&2) send(PS2_KEY_CODE_ALT);
+	if (prefix&KB_PREFIX_EXT) send(0xE0);
+	if (prefix&KB_PREFIX_F0) send(0xF0);
+	uint8_t want=prefix | ((mods&1) ? KB_MOD_RSHIFT : 0) | ((mods&2) ? KB_MOD_SYM : 0);
+	cases++;
+	if ((kb_profile!=profile) || (kb_state!=want)) {
+		failures++;
+		printf("profile %u mods %u prefix %u: setup gave profile %u state %02X\n",profile,mods,prefix,kb_profile,kb_state);
+		return;
+	}
+	send(code);
+	if (kb_state & KB_PREFIX_MASK) send(0x1C);		//a key after a prefix the byte left pending
+	send(0xE0); send(0xF0); send(code);
+	send(0xF0); send(code);
+	send(0xF0); send(0x1C);
+	send(0xF0); send(PS2_KEY_CODE_ALT);
+	send(0xF0); send(PS2_KEY_CODE_RIGHT_SHIFT);
+	//the host clock counts microseconds in 32 bits, so each case waits only as long as the queue needs
+	for (uint16_t t=0; (t<2000) && ((macro_step!=MACRO_STEP_IDLE) || (MT8808_queue_free()<MT8808_QUEUE_SIZE-1)); t++) run_ms(10);
+	run_ms(20);
+	closed_sync();
+	uint8_t held=0;
+	for (uint8_t i=0; i<sizeof(closed); i++) held+=closed[i];
+	if (held || kb_state || held_count || (macro_step!=MACRO_STEP_IDLE)) {
+		failures++;
+		printf("profile %u mods %u prefix %u byte %02X: state %02X held %u closed %u\n",profile,mods,prefix,code,kb_state,held_count,held);
+	}
+}
+
+int main(void){
+	hal_host_switch_hook=switch_hook;
+	init_timer();
+	GIMSK|=1<<INT0;
+	for (uint8_t profile=KB_PROFILE_BASIC; profile<WALK_PROFILES; profile++) {
+		for (uint8_t mods=0; mods<WALK_MODS; mods++) {
+			for (uint8_t prefix=0; prefix<KB_PREFIXES; prefix++) {
+#ifdef PS2_SCAN_CODE_SET3
+				if (prefix&KB_PREFIX_EXT) continue;
+#endif
+				for (unsigned code=0; code<256; code++) walk(profile,mods,prefix,code);
+			}
+		}
+	}
+	printf("decode: %u cases, %u failures\n",cases,failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,467 @@
+/*
+ * keymap_old.h
+ *
+ * Created: 17/10/2026 9:12:40 PM
+ *  Author: sphome
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+ */ 
+
+//the scan code tables as they were before keymap.h, with the two key ZX codes they held then
+//(E mode key in the high byte); keymap_test.c checks the layers built from keymap.h against them
+
+#ifndef KEYMAP_OLD_H_
+#define KEYMAP_OLD_H_
+
+#include <inttypes.h>
+
+#ifdef PS2_SCAN_CODE_SET3
+
+//scan code set 3 make codes, indexed by the code
+const uint16_t OLD_CODE_TO_ZX[]={
+	0x0000,	//0 0x0
+	0x0000,	//1 0x1
+	0x0000,	//2 0x2
+	0x0000,	//3 0x3
+	0x0000,	//4 0x4
+	0x0000,	//5 0x5
+	0x0000,	//6 0x6
+	0x0000,	//7 0x7 0x07 F1
+	0x0043,	//8 0x8 0x08 escape #### CP/M???
+	0x0000,	//9 0x9
+	0x0000,	//10 0xA
+	0x0000,	//11 0xB
+	0x0000,	//12 0xC
+	0xC005,	//13 0xD 0x0D tab
+	0xC081,	//14 0xE 0x0E ` (back tick) no back tick in Spectrum; tilda with no shift
+	0x0000,	//15 0xF 0x0F F2
+	0xC00E,	//16 0x10 #### PS2 unused code, assign to USR macro
+	0xC0C0,	//17 0x11 0x11 left control #### EXT MODE
+	0x0040,	//18 0x12 0x12 left shift
+	0x0000,	//19 0x13 0x13 102nd key <>
+	0x004B,	//20 0x14 0x14 CapsLock
+	0x0002,	//21 0x15 0x15 Q
+	0x0003,	//22 0x16 0x16 1
+	0x0000,	//23 0x17 0x17 F3
+	0xC099,	//24 0x18 ### PS2 unused code assigned to { macro
+	0x008F,	//25 0x19 0x19 left alt
+	0x0008,	//26 0x1A 0x1A Z
+	0x0009,	//27 0x1B 0x1B S
+	0x0001,	//28 0x1C 0x1C A
+	0x000A,	//29 0x1D 0x1D W
+	0x000B,	//30 0x1E 0x1E 2
+	0x0000,	//31 0x1F 0x1F F4
+	0x0084,	//32 0x20 ### PS2 unused code assigned to _ macro
+	0x0018,	//33 0x21 0x21 C
+	0x0010,	//34 0x22 0x22 X
+	0x0011,	//35 0x23 0x23 D
+	0x0012,	//36 0x24 0x24 E
+	0x001B,	//37 0x25 0x25 4
+	0x0013,	//38 0x26 0x26 3
+	0x0000,	//39 0x27 0x27 F5
+	0x0096,	//40 0x28 ### PS2 unused code assigned to + macro
+	0x0007,	//41 0x29 0x29 space
+	0x0020,	//42 0x2A 0x2A V
+	0x0019,	//43 0x2B 0x2B F
+	0x0022,	//44 0x2C 0x2C T
+	0x001A,	//45 0x2D 0x2D R
+	0x0023,	//46 0x2E 0x2E 5
+	0x0000,	//47 0x2F 0x2F F6
+	0xC0A1,	//48 0x30 ### PS2 unused code assigned to } macro
+	0x001F,	//49 0x31 0x31 N
+	0x0027,	//50 0x32 0x32 B
+	0x0026,	//51 0x33 0x33 H
+	0x0021,	//52 0x34 0x34 G
+	0x0025,	//53 0x35 0x35 Y
+	0x0024,	//54 0x36 0x36 6
+	0x0000,	//55 0x37 0x37 F7
+	0x0098,	//56 0x38 ### PS2 unused code assigned to ? macro
+	0x008F,	//57 0x39 0x39 right alt
+	0x0017,	//58 0x3A 0x3A M
+	0x001E,	//59 0x3B 0x3B J
+	0x001D,	//60 0x3C 0x3C U
+	0x001C,	//61 0x3D 0x3D 7
+	0x0014,	//62 0x3E 0x3E 8
+	0x0000,	//63 0x3F 0x3F F8
+	0x009A,	//64 0x40 ### PS2 unused code assigned to < macro
+	0x009F,	//65 0x41 0x41 comma ,
+	0x0016,	//66 0x42 0x42 K
+	0x0015,	//67 0x43 0x43 I
+	0x000D,	//68 0x44 0x44 O
+	0x0004,	//69 0x45 0x45 0 (zero)
+	0x000C,	//70 0x46 0x46 9
+	0x0000,	//71 0x47 0x47 F9
+	0x00A2,	//72 0x48 ### PS2 unused code assigned to > macro
+	0x0097,	//73 0x49 0x49 .
+	0x00A0,	//74 0x4A 0x4A /
+	0x000E,	//75 0x4B 0x4B L
+	0x008D,	//76 0x4C 0x4C ;
+	0x0005,	//77 0x4D 0x4D P
+	0x009E,	//78 0x4E 0x4E -
+	0x0000,	//79 0x4F 0x4F F10
+	0x0088,	//80 0x50 ### PS2 unused code assigned to : macro
+	0x0085,	//81 0x51 ### PS2 unused code assigned to " macro
+	0x009C,	//82 0x52 0x52 '
+	0x0000,	//83 0x53 0x53 102nd key #
+	0xC0A5,	//84 0x54 0x54 [
+	0x008E,	//85 0x55 0x55 =
+	0x0000,	//86 0x56 0x56 F11
+	0x0000,	//87 0x57 0x57 print screen
+	0xC0C0,	//88 0x58 0x58 right control E mode
+	0x0000,	//89 0x59 0x59 right shift - not CAPS but shift for Symbols on PS2 keyboard
+	0x0006,	//90 0x5A 0x5A enter
+	0xC09D,	//91 0x5B 0x5B ]
+	0xC091,	//92 0x5C 0x5C backslash
+	0xC089,	//93 0x5D ### PS2 unused code assigned to | macro
+	0x0000,	//94 0x5E 0x5E F12
+	0x0000,	//95 0x5F 0x5F ScrollLock
+	0x0064,	//96 0x60 0x60 cursor down
+	0x0063,	//97 0x61 0x61 cursor left
+	0x0000,	//98 0x62 0x62 pause
+	0x005C,	//99 0x63 0x63 cursor up
+	0x0000,	//100 0x64 0x64 delete
+	0x0000,	//101 0x65 0x65 end
+	0x0044,	//102 0x66 0x66 backspace
+	0x0000,	//103 0x67 0x67 insert
+	0x0000,	//104 0x68
+	0x0003,	//105 0x69 0x69 (keypad) 1
+	0x0054,	//106 0x6A 0x6A cursor right
+	0x001B,	//107 0x6B 0x6B (keypad) 4
+	0x001C,	//108 0x6C 0x6C (keypad) 7
+	0x0000,	//109 0x6D 0x6D page down
+	0x0000,	//110 0x6E 0x6E home
+	0x0000,	//111 0x6F 0x6F page up
+	0x0004,	//112 0x70 0x70 (keypad) 0
+	0x0097,	//113 0x71 0x71 (keypad) .
+	0x000B,	//114 0x72 0x72 (keypad) 2
+	0x0023,	//115 0x73 0x73 (keypad) 5
+	0x0024,	//116 0x74 0x74 (keypad) 6
+	0x0014,	//117 0x75 0x75 (keypad) 8
+	0xC08C,	//118 0x76 0x76 NumberLock # Basic CAT command
+	0x00A0,	//119 0x77 0x77 (keypad) /
+	0x0000,	//120 0x78
+	0x0006,	//121 0x79 0x79 (keypad) enter
+	0x0013,	//122 0x7A 0x7A (keypad) 3
+	0x0000,	//123 0x7B
+	0x0096,	//124 0x7C 0x7C (keypad) +
+	0x000C,	//125 0x7D 0x7D (keypad) 9
+	0x00A7,	//126 0x7E 0x7E (keypad) *
+	0x0000,	//127 0x7F
+	0x0000,	//128 0x80
+	0x0000,	//129 0x81
+	0x0000,	//130 0x82
+	0x0000,	//131 0x83
+	0x009E 	//132 0x84 0x84 (keypad) -
+};
+
+//code of a symbol key, code of the symbol it gives with right shift
+const uint8_t OLD_RIGHT_SHIFTED_CODES[][2]={
+	{65,	64},
+	{73,	72},
+	{82,	81},
+	{84,	24},
+	{78,	32},
+	{85,	40},
+	{91,	48},
+	{92,	93},
+	{74,	56},
+	{76,	80}
+};
+
+#else
+
+//scan code set 2 make codes, indexed by the code
+const uint16_t OLD_CODE_TO_ZX[]={
+	0x0000,	//0 0x0 0x00 no key
+	0x0000,	//1 0x1 0x01 F9
+	0x0000,	//2 0x2
+	0x0000,	//3 0x3 0x03 F5
+	0x0000,	//4 0x4 0x04 F3
+	0x0000,	//5 0x5 0x05 F1
+	0x0000,	//6 0x6 0x06 F2
+	0x0000,	//7 0x7 0x07 F12
+	0x0000,	//8 0x8
+	0x0000,	//9 0x9 0x09 F10
+	0x0000,	//10 0xA 0x0A F8
+	0x0000,	//11 0xB 0x0B F6
+	0x0000,	//12 0xC 0x0C F4
+	0xC005,	//13 0xD 0x0D tab
+	0xC081,	//14 0xE 0x0E ` (back tick); no back tick in Spectrum; tilda with no shift
+	0xC00E,	//15 0xF #### PS2 unused code, assign to USR macro; WORKS
+	0x0000,	//16 0x10
+	0x008F,	//17 0x11 0x11 left alt
+	0x0040,	//18 0x12 0x12 left shift
+	0x0000,	//19 0x13
+	0xC0C0,	//20 0x14 0x14 left control #### EXT MODE
+	0x0002,	//21 0x15 0x15 Q
+	0x0003,	//22 0x16 0x16 1
+	0x0000,	//23 0x17
+	0x0000,	//24 0x18
+	0x0000,	//25 0x19
+	0x0008,	//26 0x1A 0x1A Z
+	0x0009,	//27 0x1B 0x1B S
+	0x0001,	//28 0x1C 0x1C A
+	0x000A,	//29 0x1D 0x1D W
+	0x000B,	//30 0x1E 0x1E 2
+	0x0000,	//31 0x1F
+	0x0000,	//32 0x20
+	0x0018,	//33 0x21 0x21 C
+	0x0010,	//34 0x22 0x22 X
+	0x0011,	//35 0x23 0x23 D
+	0x0012,	//36 0x24 0x24 E
+	0x001B,	//37 0x25 0x25 4
+	0x0013,	//38 0x26 0x26 3
+	0x0000,	//39 0x27
+	0x0000,	//40 0x28
+	0x0007,	//41 0x29 0x29 space
+	0x0020,	//42 0x2A 0x2A V
+	0x0019,	//43 0x2B 0x2B F
+	0x0022,	//44 0x2C 0x2C T
+	0x001A,	//45 0x2D 0x2D R
+	0x0023,	//46 0x2E 0x2E 5
+	0x0000,	//47 0x2F
+	0x0000,	//48 0x30
+	0x001F,	//49 0x31 0x31 N
+	0x0027,	//50 0x32 0x32 B
+	0x0026,	//51 0x33 0x33 H
+	0x0021,	//52 0x34 0x34 G
+	0x0025,	//53 0x35 0x35 Y
+	0x0024,	//54 0x36 0x36 6
+	0x0000,	//55 0x37
+	0x0000,	//56 0x38
+	0x0000,	//57 0x39
+	0x0017,	//58 0x3A 0x3A M
+	0x001E,	//59 0x3B 0x3B J
+	0x001D,	//60 0x3C 0x3C U
+	0x001C,	//61 0x3D 0x3D 7
+	0x0014,	//62 0x3E 0x3E 8
+	0x0000,	//63 0x3F
+	0x009A,	//64 0x40 ### PS2 unused code assigned to < macro
+	0x009F,	//65 0x41 0x41 comma ,
+	0x0016,	//66 0x42 0x42 K
+	0x0015,	//67 0x43 0x43 I
+	0x000D,	//68 0x44 0x44 O
+	0x0004,	//69 0x45 0x45 0 (zero)
+	0x000C,	//70 0x46 0x46 9
+	0x0098,	//71 0x47 ### PS2 unused code assigned to ? macro
+	0x00A2,	//72 0x48 ### PS2 unused code assigned to > macro
+	0x0097,	//73 0x49 0x49 .
+	0x00A0,	//74 0x4A 0x4A /
+	0x000E,	//75 0x4B 0x4B L
+	0x008D,	//76 0x4C 0x4C ;
+	0x0005,	//77 0x4D 0x4D P
+	0x009E,	//78 0x4E 0x4E -
+	0x0084,	//79 0x4F ### PS2 unused code assigned to _ macro
+	0x0088,	//80 0x50 ### PS2 unused code assigned to : macro
+	0x0085,	//81 0x51 ### PS2 unused code assigned to " macro
+	0x009C,	//82 0x52 0x52 '
+	0xC099,	//83 0x53 ### PS2 unused code assigned to { macro
+	0xC0A5,	//84 0x54 0x54 [
+	0x008E,	//85 0x55 0x55 =
+	0x0096,	//86 0x56 ### PS2 unused code assigned to + macro
+	0x0000,	//87 0x57
+	0x004B,	//88 0x58 0x58 CapsLock
+	0x0000,	//89 0x59 0x59 right shift - not CAPS but shift for Symbols on PS2 keyboard
+	0x0006,	//90 0x5A 0x5A enter
+	0xC09D,	//91 0x5B 0x5B ]
+	0xC0A1,	//92 0x5C ### PS2 unused code assigned to } macro
+	0xC091,	//93 0x5D 0x5D backslash,
+	0xC089,	//94 0x5E ### PS2 unused code assigned to | macro
+	0x0000,	//95 0x5F
+	0x0000,	//96 0x60
+	0x0000,	//97 0x61
+	0x0000,	//98 0x62
+	0x0000,	//99 0x63
+	0x0000,	//100 0x64
+	0x0000,	//101 0x65
+	0x0044,	//102 0x66 0x66 backspace
+	0x0000,	//103 0x67
+	0x0000,	//104 0x68
+	0x0003,	//105 0x69 0x69 (keypad) 1
+	0x0000,	//106 0x6A
+	0x001B,	//107 0x6B 0x6B (keypad) 4
+	0x001C,	//108 0x6C 0x6C (keypad) 7
+	0x0000,	//109 0x6D
+	0x0000,	//110 0x6E
+	0x0000,	//111 0x6F
+	0x0004,	//112 0x70 0x70 (keypad) 0
+	0x0097,	//113 0x71 0x71 (keypad) .
+	0x000B,	//114 0x72 0x72 (keypad) 2
+	0x0023,	//115 0x73 0x73 (keypad) 5
+	0x0024,	//116 0x74 0x74 (keypad) 6
+	0x0014,	//117 0x75 0x75 (keypad) 8
+	0x0043,	//118 0x76 0x76 escape #### CP/M???
+	0xC08C,	//119 0x77 0x77 NumberLock # Basic CAT command
+	0x0000,	//120 0x78 0x78 F11
+	0x0096,	//121 0x79 0x79 (keypad) +
+	0x0013,	//122 0x7A 0x7A (keypad) 3
+	0x009E,	//123 0x7B 0x7B (keypad) -
+	0x00A7,	//124 0x7C 0x7C (keypad) *
+	0x000C,	//125 0x7D 0x7D (keypad) 9
+	0x0000,	//126 0x7E 0x7E ScrollLock #CP/M
+	0x0000,	//127 0x7F
+	0x0000,	//128 0x80
+	0x0000,	//129 0x81
+	0x0000,	//130 0x82
+	0x0000 	//131 0x83 0x83 F7
+};
+
+//codes after an E0 prefix
+const uint16_t OLD_E0_CODE_TO_ZX[]={
+	0x0000,	//0 0
+	0x0000,	//1 1
+	0x0000,	//2 2
+	0x0000,	//3 3
+	0x0000,	//4 4
+	0x0000,	//5 5
+	0x0000,	//6 6
+	0x0000,	//7 7
+	0x0000,	//8 8
+	0x0000,	//9 9
+	0x0000,	//10 A
+	0x0000,	//11 B
+	0x0000,	//12 C
+	0x0000,	//13 D
+	0x0000,	//14 E
+	0x0000,	//15 F
+	0x0000,	//16 10 0xE0 0x10 (multimedia) WWW search
+	0x008F,	//17 11 0xE0 0x11 right alt
+	0x0000,	//18 12 0xE0 0x12 0xE0 0x7C print screen SPECIAL
+	0x0000,	//19 13
+	0xC0C0,	//20 14 0xE0 0x14 right control E mode
+	0x0000,	//21 15 0xE0 0x15 (multimedia) previous track
+	0x0000,	//22 16
+	0x0000,	//23 17
+	0x0000,	//24 18 0xE0 0x18 (multimedia) WWW favourites
+	0x0000,	//25 19
+	0x0000,	//26 1A
+	0x0000,	//27 1B
+	0x0000,	//28 1C
+	0x0000,	//29 1D
+	0x0000,	//30 1E
+	0x0000,	//31 1F 0xE0 0x1F left GUI
+	0x0000,	//32 20 0xE0 0x20 (multimedia) WWW refresh
+	0x0000,	//33 21 0xE0 0x21 (multimedia) volume down
+	0x0000,	//34 22
+	0x0000,	//35 23 0xE0 0x23 (multimedia) mute
+	0x0000,	//36 24
+	0x0000,	//37 25
+	0x0000,	//38 26
+	0x0000,	//39 27 0xE0 0x27 right GUI
+	0x0000,	//40 28 0xE0 0x28 (multimedia) WWW stop
+	0x0000,	//41 29
+	0x0000,	//42 2A
+	0x0000,	//43 2B 0xE0 0x2B (multimedia) calculator
+	0x0000,	//44 2C
+	0x0000,	//45 2D
+	0x0000,	//46 2E
+	0x0000,	//47 2F 0xE0 0x2F apps
+	0x0000,	//48 30 0xE0 0x30 (multimedia) WWW forward
+	0x0000,	//49 31
+	0x0000,	//50 32 0xE0 0x32 (multimedia) volume up
+	0x0000,	//51 33
+	0x0000,	//52 34 0xE0 0x34 (multimedia) play/pause
+	0x0000,	//53 35
+	0x0000,	//54 36
+	0x0000,	//55 37 0xE0 0x37 (ACPI) power
+	0x0000,	//56 38 0xE0 0x38 (multimedia) WWW back
+	0x0000,	//57 39
+	0x0000,	//58 3A 0xE0 0x3A (multimedia) WWW home
+	0x0000,	//59 3B 0xE0 0x3B (multimedia) stop
+	0x0000,	//60 3C
+	0x0000,	//61 3D
+	0x0000,	//62 3E
+	0x0000,	//63 3F 0xE0 0x3F (ACPI) sleep
+	0x0000,	//64 40 0xE0 0x40 (multimedia) my computer
+	0x0000,	//65 41
+	0x0000,	//66 42
+	0x0000,	//67 43
+	0x0000,	//68 44
+	0x0000,	//69 45
+	0x0000,	//70 46
+	0x0000,	//71 47
+	0x0000,	//72 48 0xE0 0x48 (multimedia) email
+	0x0000,	//73 49
+	0x00A0,	//74 4A 0xE0 0x4A (keypad) /
+	0x0000,	//75 4B
+	0x0000,	//76 4C
+	0x0000,	//77 4D 0xE0 0x4D (multimedia) next track
+	0x0000,	//78 4E
+	0x0000,	//79 4F
+	0x0000,	//80 50 0xE0 0x50 (multimedia) media select
+	0x0000,	//81 51
+	0x0000,	//82 52
+	0x0000,	//83 53
+	0x0000,	//84 54
+	0x0000,	//85 55
+	0x0000,	//86 56
+	0x0000,	//87 57
+	0x0000,	//88 58
+	0x0000,	//89 59
+	0x0006,	//90 5A 0xE0 0x5A (keypad) enter
+	0x0000,	//91 5B
+	0x0000,	//92 5C cannot have 0xE0 after E0 extended
+	0x0000,	//93 5D cannot have E1 after E0
+	0x0000,	//94 5E 0xE0 0x5E (ACPI) wake
+	0x0000,	//95 5F
+	0x0000,	//96 60
+	0x0000,	//97 61
+	0x0000,	//98 62
+	0x0000,	//99 63
+	0x0000,	//100 64
+	0x0000,	//101 65
+	0x0000,	//102 66
+	0x0000,	//103 67
+	0x0000,	//104 68
+	0x0000,	//105 69 0xE0 0x69 end ##CP/M cursor end of line
+	0x0000,	//106 6A
+	0x0063,	//107 6B 0xE0 0x6B cursor left
+	0x0000,	//108 6C 0xE0 0x6C home ##CP/M end cursor home
+	0x0000,	//109 6D
+	0x0000,	//110 6E
+	0x0000,	//111 6F
+	0x0000,	//112 70 0xE0 0x70 insert ##CP/M /
+	0x0000,	//113 71 0xE0 0x71 delete ##CP/M /
+	0x0064,	//114 72 0xE0 0x72 cursor down
+	0x0000,	//115 73
+	0x0054,	//116 74 0xE0 0x74 cursor right
+	0x005C,	//117 75 0xE0 0x75 cursor up
+	0x0000,	//118 76
+	0x0000,	//119 77
+	0x0000,	//120 78
+	0x0000,	//121 79
+	0x0000,	//122 7A 0xE0 0x7A page down ##CP/M
+	0x0000,	//123 7B
+	0x0000,	//124 7C
+	0x0000 	//125 7D 0xE0 0x7D page up ##CP/M
+};
+
+//code of a symbol key, code of the symbol it gives with right shift
+const uint8_t OLD_RIGHT_SHIFTED_CODES[][2]={
+	{65,	64},
+	{73,	72},
+	{82,	81},
+	{84,	83},
+	{78,	79},
+	{85,	86},
+	{91,	92},
+	{93,	94},
+	{74,	71},
+	{76,	80}
+};
+
+#endif
+
+#endif /* KEYMAP_OLD_H_ */
@@ -0,0 +1,105 @@
+/*
+ * keymap_test.c
+ *
+ * Created: 17/10/2026 9:20:15 PM
+ *  Author: sphome
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)    
+    
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+ */ 
+
+/*
+ Keymap regression test, see "make test" in firmware/Makefile.
+
+ Every scan code of the set the firmware is built for is looked up the way the decoder does it, in the
+ BASIC profile, alone and after E0, and compared with the tables of keymap_old.h; so are the symbol keys
+ the old tables shifted with right shift. The digits only got shifted symbols with the keymap layers, the
+ old tables have nothing to compare them with. ps2_kb.c is included whole so its static lookups are reachable.
+*/
+
+#include <stdio.h>
+#include <ps2_kb.c>
+#include "keymap_old.h"
+
+#define OLD_SIZE(t)	(sizeof(t)/sizeof(t[0]))
+
+//USR moved off the code the old tables used as a spare, PS2_KEY_CODE_USR, onto the menu key; set 3 has F14 there
+#ifdef PS2_SCAN_CODE_SET3
+#define OLD_USR_CODE	0x10
+#define USR_CODE		0x8D
+#define USR_EXT			0
+#else
+#define OLD_USR_CODE	0x0F
+#define USR_CODE		0x2F
+#define USR_EXT			1
+#endif
+
+static unsigned checked,failures;
+
+static uint16_t new_zx(uint8_t code, uint8_t ext, uint8_t mods){
+	kb_state=mods;
+	return zx_expand(ps2_code_to_zx(code,ext));
+}
+
+static uint16_t old_zx(const uint16_t * table, unsigned size, unsigned code){
+	return (code<size) ? table[code] : PS2_NO_KEY;
+}
+
+//codes no keyboard sends, the old tables only used them for the right shifted symbols
+static int old_shift_code(unsigned code){
+	for (unsigned i=0; i<OLD_SIZE(OLD_RIGHT_SHIFTED_CODES); i++) {
+		if (OLD_RIGHT_SHIFTED_CODES[i][1]==code) return 1;
+	}
+	return 0;
+}
+
+static void check(const char * what, unsigned code, uint16_t now, uint16_t before){
+	checked++;
+	if (now==before) return;
+	failures++;
+	printf("%s %02X: %04X, was %04X\n",what,code,now,before);
+}
+
+int main(void){
+#ifdef KB_CPM_PROFILE
+	kb_profile=KB_PROFILE_BASIC;
+#endif
+	for (unsigned code=PS2_CODE_FIRST; code<=PS2_CODE_LAST; code++) {
+		if ((code==OLD_USR_CODE) || ((code==USR_CODE) && !USR_EXT)) continue;
+		if (!old_shift_code(code)) check("key",code,new_zx(code,0,0),old_zx(OLD_CODE_TO_ZX,OLD_SIZE(OLD_CODE_TO_ZX),code));
+#ifndef PS2_SCAN_CODE_SET3
+		if (code==USR_CODE) continue;
+		check("E0",code,new_zx(code,1,0),old_zx(OLD_E0_CODE_TO_ZX,OLD_SIZE(OLD_E0_CODE_TO_ZX),code));
+		check("E0 right shift",code,new_zx(code,1,KB_MOD_RSHIFT),old_zx(OLD_E0_CODE_TO_ZX,OLD_SIZE(OLD_E0_CODE_TO_ZX),code));
+#endif
+	}
+	check("old USR",OLD_USR_CODE,new_zx(OLD_USR_CODE,0,0),PS2_NO_KEY);
+	check("USR",USR_CODE,new_zx(USR_CODE,USR_EXT,0),old_zx(OLD_CODE_TO_ZX,OLD_SIZE(OLD_CODE_TO_ZX),OLD_USR_CODE));
+	check("USR right shift",USR_CODE,new_zx(USR_CODE,USR_EXT,KB_MOD_RSHIFT),old_zx(OLD_CODE_TO_ZX,OLD_SIZE(OLD_CODE_TO_ZX),OLD_USR_CODE));
+	for (unsigned i=0; i<OLD_SIZE(OLD_RIGHT_SHIFTED_CODES); i++) {
+		uint8_t code=OLD_RIGHT_SHIFTED_CODES[i][0];
+		check("right shift",code,new_zx(code,0,KB_MOD_RSHIFT),old_zx(OLD_CODE_TO_ZX,OLD_SIZE(OLD_CODE_TO_ZX),OLD_RIGHT_SHIFTED_CODES[i][1]));
+	}
+	//codes outside the layers are never looked up, the old tables had no key there either
+	for (unsigned code=0; code<OLD_SIZE(OLD_CODE_TO_ZX); code++) {
+		if ((code<PS2_CODE_FIRST) || (code>PS2_CODE_LAST)) check("key",code,PS2_NO_KEY,OLD_CODE_TO_ZX[code]);
+	}
+#ifndef PS2_SCAN_CODE_SET3
+	for (unsigned code=0; code<OLD_SIZE(OLD_E0_CODE_TO_ZX); code++) {
+		if ((code<PS2_CODE_FIRST) || (code>PS2_CODE_LAST)) check("E0",code,PS2_NO_KEY,OLD_E0_CODE_TO_ZX[code]);
+	}
+#endif
+	printf("keymap: %u lookups, %u differences\n",checked,failures);
+	return failures ? 1 : 0;
+}
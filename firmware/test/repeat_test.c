@@ -0,0 +1,105 @@
+/*
+ * repeat_test.c
+ *
+ * Created: 18/10/2026 10:12:05 AM
+ *  Author: sphome
+    Copyright (C) 2024 Stefan V. Pantazi (svpantazi@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+/*
+ Synthesized repeat test, see "make test" in firmware/Makefile.
+
+ A is held until KB_REPEAT_SYNTH opens it for the first repeat, let go while it is open, then B is tapped.
+ Nothing may be left closed and nothing may repeat afterwards; the release used to leave the repeat
+ pending, and the make of B then closed whatever lay past the held keys.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#define KB_REPEAT_SYNTH
+#include <ps2_kb.c>
+
+#define KEY_A		0x1C	//the same in scan code set 2 and 3
+#define KEY_B		0x32
+
+static uint8_t closed[64];
+static uint32_t resets_seen;
+static unsigned failures;
+
+//a switch reset opens every switch
+static void closed_sync(void){
+	if (hal_host_reset_count==resets_seen) return;
+	memset(closed,0,sizeof(closed));
+	resets_seen=hal_host_reset_count;
+}
+
+static void switch_hook(uint32_t time_us, uint8_t addr, uint8_t state){
+	(void)time_us;
+	closed_sync();
+	closed[addr]=state;
+}
+
+static uint8_t closed_count(void){
+	uint8_t n=0;
+	closed_sync();
+	for (uint8_t i=0; i<sizeof(closed); i++) n+=closed[i];
+	return n;
+}
+
+static void run_ms(uint32_t ms){
+	while (ms--) {
+		hal_host_advance_us(1000);
+		poll_kb();
+	}
+}
+
+static void send(uint8_t byte){
+	hal_host_ps2_send(byte);
+	poll_kb();
+	run_ms(2);
+}
+
+static void check(const char * what, int ok){
+	if (ok) return;
+	failures++;
+	printf("%s: state %02X held %u closed %u repeat_up %u\n",what,kb_state,held_count,closed_count(),repeat_up);
+}
+
+int main(void){
+	hal_host_switch_hook=switch_hook;
+	init_timer();
+	GIMSK|=1<<INT0;
+	init_kb();
+	run_ms(50);
+	closed_sync();
+
+	send(KEY_A);
+	run_ms(20);
+	check("A pressed",closed_count()>0);
+	//the first repeat opens A for KB_REPEAT_GAP ms
+	for (uint16_t t=0; (t<2*KB_REPEAT_DELAY) && !repeat_up; t++) run_ms(1);
+	run_ms(5);
+	check("A open for the first repeat",repeat_up && (closed_count()==0));
+	send(0xF0); send(KEY_A);
+	check("A let go while open",!repeat_up && !held_count);
+	send(KEY_B);
+	send(0xF0); send(KEY_B);
+	run_ms(KB_REPEAT_DELAY+KB_REPEAT_RATE);
+	check("B tapped",!held_count && (closed_count()==0));
+
+	printf("repeat: %u failures\n",failures);
+	return failures ? 1 : 0;
+}
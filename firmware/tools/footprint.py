@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+# HC2000 PS/2 keyboard adapter firmware footprint check
+#
+#   footprint.py --flash BYTES --ram BYTES [--objdump avr-objdump] firmware.elf file.su...
+#
+# Reports flash, static RAM and the worst case stack of every call path from main() and from each
+# interrupt handler, then fails when flash or RAM is over budget. A handler that turns interrupts back
+# on with sei (the timer one) can have any other handler on top of it, the others do not nest; the RAM
+# check is data + bss + deepest main() path + deepest interrupt path, nested handlers included.
+#
+# Stack sizes come from the .su files of -fstack-usage, the call graph from the disassembly, so
+# inlining and tail calls are seen as the compiler left them. Every call adds its return address.
+# Functions without a .su entry (libgcc, crt) count as 0 bytes and are listed; indirect calls are
+# not followed and are listed as well. The -mcall-prologues helpers of libgcc jump in and ijmp back to
+# the function, their pushes are in its .su frame already.
+
+import argparse
+import re
+import subprocess
+import sys
+
+RETURN_ADDRESS = 2 # PC bytes pushed by a call or by an interrupt on a 2..8 KB AVR
+ISR_PREFIX = "__vector_"
+PROLOGUE_HELPERS = ("__prologue_saves__", "__epilogue_restores__")
+
+
+def read_stack_usage(paths):
+	frames = {}
+	for path in paths:
+		with open(path) as su:
+			for line in su:
+				# file.c:12:6:function	bytes	static|dynamic|bounded
+				fields = line.rstrip("\n").split("\t")
+				if len(fields) < 3:
+					continue
+				name = fields[0].rsplit(":", 1)[-1]
+				frames[name] = max(frames.get(name, 0), int(fields[1]))
+	return frames
+
+
+def read_call_graph(objdump, elf):
+	calls = {}
+	indirect = set()
+	nesting = set()
+	function = None
+	listing = subprocess.run([objdump, "-d", elf], capture_output=True, text=True, check=True).stdout
+	for line in listing.splitlines():
+		label = re.match(r"^[0-9a-f]+ <([^>]+)>:$", line)
+		if label:
+			function = label.group(1)
+			calls.setdefault(function, set())
+			continue
+		if function is None:
+			continue
+		if re.search(r"\tsei\b", line):
+			nesting.add(function)
+			continue
+		if re.search(r"\t(e?icall|e?ijmp)\b", line):
+			if function not in PROLOGUE_HELPERS:
+				indirect.add(function)
+			continue
+		call = re.search(r"\t(r?call|r?jmp|jmp|call)\s.*<([^>+]+)>$", line)
+		if call and call.group(2) != function and call.group(2) not in PROLOGUE_HELPERS:
+			calls[function].add(call.group(2))
+	return calls, indirect, nesting
+
+
+def deepest(function, calls, frames, unknown, path=()):
+	# worst case stack from entering function, and the path that gives it; recursion is not followed
+	if function in path:
+		return 0, path + (function + " (recursion)",)
+	if function not in frames:
+		unknown.add(function)
+	best, best_path = 0, ()
+	for callee in calls.get(function, ()):
+		size, callee_path = deepest(callee, calls, frames, unknown, path + (function,))
+		if size + RETURN_ADDRESS > best:
+			best, best_path = size + RETURN_ADDRESS, callee_path
+	return frames.get(function, 0) + best, best_path or path + (function,)
+
+
+def section_sizes(objdump, elf):
+	sizes = {}
+	headers = subprocess.run([objdump, "-h", elf], capture_output=True, text=True, check=True).stdout
+	for line in headers.splitlines():
+		fields = line.split()
+		if len(fields) >= 3 and fields[0].isdigit():
+			sizes[fields[1]] = int(fields[2], 16)
+	return sizes
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--flash", type=int, required=True)
+	parser.add_argument("--ram", type=int, required=True)
+	parser.add_argument("--objdump", default="avr-objdump")
+	parser.add_argument("elf")
+	parser.add_argument("su", nargs="+")
+	args = parser.parse_args()
+
+	sizes = section_sizes(args.objdump, args.elf)
+	flash = sizes.get(".text", 0) + sizes.get(".data", 0)
+	data = sizes.get(".data", 0) + sizes.get(".bss", 0) + sizes.get(".noinit", 0)
+
+	frames = read_stack_usage(args.su)
+	calls, indirect, nesting = read_call_graph(args.objdump, args.elf)
+	unknown = set()
+
+	main_stack, main_path = deepest("main", calls, frames, unknown)
+	handlers = {}
+	for function in sorted(calls):
+		if function.startswith(ISR_PREFIX) and function != ISR_PREFIX + "default":
+			size, path = deepest(function, calls, frames, unknown)
+			size += RETURN_ADDRESS
+			print("stack %-16s %4d  %s" % (function, size, " > ".join(path)))
+			handlers[function] = (size, path)
+	isr_stack, isr_path = 0, ()
+	for function, (size, path) in handlers.items():
+		if function in nesting:
+			# the deepest other handler can come in once interrupts are back on
+			others = [handlers[other] for other in handlers if other != function]
+			if others:
+				nested_size, nested_path = max(others)
+				size, path = size + nested_size, path + ("(interrupted)",) + nested_path
+				print("stack %-16s %4d  %s" % (function + "+", size, " > ".join(path)))
+		if size > isr_stack:
+			isr_stack, isr_path = size, path
+	print("stack %-16s %4d  %s" % ("main", main_stack, " > ".join(main_path)))
+
+	ram = data + main_stack + isr_stack
+	print("flash %d of %d bytes" % (flash, args.flash))
+	print("ram   %d of %d bytes (data %d, main stack %d, interrupt stack %d)" % (ram, args.ram, data, main_stack, isr_stack))
+	if unknown:
+		print("no stack usage for: " + " ".join(sorted(unknown)))
+	if indirect:
+		print("indirect calls not followed in: " + " ".join(sorted(indirect)))
+
+	failed = False
+	if flash > args.flash:
+		print("FAIL flash over budget by %d bytes" % (flash - args.flash))
+		failed = True
+	if ram > args.ram:
+		print("FAIL ram over budget by %d bytes" % (ram - args.ram))
+		failed = True
+	return 1 if failed else 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+# HC2000 PS/2 keyboard adapter macro compiler
+#
+#   macros.py src/macros.txt src/macros.h
+#
+# Turns the macro text of macros.txt into the ZX key codes the firmware plays, one byte per key
+# (see src/zx_keys.h), so macros are typed straight into the MT8808 without going through
+# the PS/2 decoder. Each line of macros.txt is
+#
+#   NAME	profile	text
+#
+# where profile is safe, basic or cpm (macro_profile_t). In the text \n is ENTER, \\ a backslash,
+# \{ a brace and {NAME} the key ZX_KEY_NAME; the rest are typed as the characters they are, capitals
+# with CAPS and symbols with SYM or through E mode. With the basic profile BASIC keywords are typed
+# with their single key the way the ROM expects them: K mode keywords at the start of a statement,
+# the SYM and E mode ones anywhere, and the spaces around a keyword are left to the ROM.
+
+import re
+import sys
+
+# K mode: the statement keyword on each letter key
+K_MODE_KEYWORDS = {
+	"NEW": "A", "BORDER": "B", "CONTINUE": "C", "DIM": "D", "REM": "E", "FOR": "F", "GO TO": "G",
+	"GO SUB": "H", "INPUT": "I", "LOAD": "J", "LIST": "K", "LET": "L", "PAUSE": "M", "NEXT": "N",
+	"POKE": "O", "PRINT": "P", "PLOT": "Q", "RUN": "R", "SAVE": "S", "RANDOMIZE": "T", "IF": "U",
+	"CLS": "V", "DRAW": "W", "CLEAR": "X", "RETURN": "Y", "COPY": "Z",
+}
+
+# L mode keywords, with the key that types them
+L_MODE_KEYWORDS = {
+	"<=": "ZX_KEY_LTEQ", "<>": "ZX_KEY_DIFF", ">=": "ZX_KEY_GTEQ",
+	"AND": "ZX_SYM(ZX_KEY_Y)", "OR": "ZX_SYM(ZX_KEY_U)", "AT": "ZX_SYM(ZX_KEY_I)",
+	"STOP": "ZX_SYM(ZX_KEY_A)", "NOT": "ZX_SYM(ZX_KEY_S)", "STEP": "ZX_SYM(ZX_KEY_D)",
+	"TO": "ZX_SYM(ZX_KEY_F)", "THEN": "ZX_SYM(ZX_KEY_G)",
+	"USR": "ZX_KEY_USR", "CAT": "ZX_KEY_CAT",
+}
+
+# keywords after which the ROM is back in K mode
+K_MODE_AFTER = ("THEN",)
+
+SYMBOLS = {
+	" ": "ZX_KEY_SP", "\n": "ZX_KEY_CR",
+	":": "ZX_KEY_COLON", "?": "ZX_KEY_QMARK", "/": "ZX_KEY_SLASH", "*": "ZX_KEY_STAR",
+	",": "ZX_KEY_COMMA", ".": "ZX_KEY_PERIOD", "^": "ZX_KEY_HAT", "-": "ZX_KEY_MINUS",
+	"+": "ZX_KEY_PLUS", "=": "ZX_KEY_EQUAL", "<": "ZX_KEY_ANG_BRACKET_OPEN",
+	">": "ZX_KEY_ANG_BRACKET_CLOSE", ";": "ZX_KEY_SEMICOLON", '"': "ZX_KEY_DOUBLE_QUOTE",
+	"!": "ZX_KEY_EXCL", "@": "ZX_KEY_AT", "#": "ZX_KEY_HASH", "$": "ZX_KEY_DOLLAR",
+	"%": "ZX_KEY_PERCENT", "&": "ZX_KEY_AMPER", "'": "ZX_KEY_SINGLE_QUOTE",
+	"(": "ZX_KEY_ROUND_BRACKET_OPEN", ")": "ZX_KEY_ROUND_BRACKET_CLOSE", "_": "ZX_KEY_UNDERSCORE",
+	"£": "ZX_KEY_POUND", "©": "ZX_KEY_COPYRIGHT",
+	"[": "ZX_KEY_SQ_BRACKET_OPEN", "]": "ZX_KEY_SQ_BRACKET_CLOSE", "~": "ZX_KEY_TILDE",
+	"|": "ZX_KEY_PIPE", "\\": "ZX_KEY_BACKSLASH", "{": "ZX_KEY_CURL_BRACKET_OPEN",
+	"}": "ZX_KEY_CURL_BRACKET_CLOSE",
+}
+
+PROFILES = ("safe", "basic", "cpm")
+
+
+class MacroError(Exception):
+	pass
+
+
+def character_key(char):
+	if char.isascii() and char.isdigit():
+		return "ZX_KEY_" + char
+	if char.isascii() and char.islower():
+		return "ZX_KEY_" + char.upper()
+	if char.isascii() and char.isupper():
+		return "ZX_CAP(ZX_KEY_%s)" % char
+	if char in SYMBOLS:
+		return SYMBOLS[char]
+	raise MacroError("no key types %r" % char)
+
+
+def word_at(text, i, word):
+	# word at i, not run into letters on either side
+	if not text.startswith(word, i):
+		return False
+	if word[-1].isalpha() and i + len(word) < len(text) and text[i + len(word)].isalpha():
+		return False
+	return not (word[0].isalpha() and i > 0 and text[i - 1].isalpha())
+
+
+def tokens(text):
+	# (text, key) pairs with the escapes resolved; a key of None is a plain character
+	i = 0
+	while i < len(text):
+		if text[i] == "\\" and i + 1 < len(text):
+			escaped = text[i + 1]
+			yield ("\n" if escaped == "n" else escaped), None
+			i += 2
+		elif text[i] == "{":
+			end = text.find("}", i)
+			if end < 0:
+				raise MacroError("unterminated {")
+			yield text[i:end + 1], "ZX_KEY_" + text[i + 1:end]
+			i = end + 1
+		else:
+			yield text[i], None
+			i += 1
+
+
+def compile_text(text, profile):
+	keys = []
+	chars = []
+	for char, key in tokens(text):
+		if key is not None:
+			keys.append(key)
+			chars.append(None)
+		else:
+			keys.append(None)
+			chars.append(char)
+	if profile != "basic":
+		return [key or character_key(char) for key, char in zip(keys, chars)]
+
+	# keywords are matched on the plain characters, a {NAME} key breaks a word
+	plain = "".join(char if char is not None else "\0" for char in chars)
+	out = []
+	k_mode = True
+	quoted = False
+	i = 0
+	while i < len(plain):
+		if keys[i] is not None:
+			out.append(keys[i])
+			k_mode = keys[i] == "ZX_KEY_CR"
+			quoted = quoted and not k_mode
+			i += 1
+			continue
+		keyword = None
+		if k_mode and not quoted:
+			for word in sorted(K_MODE_KEYWORDS, key=len, reverse=True):
+				if word_at(plain, i, word):
+					keyword, key = word, "ZX_KEY_" + K_MODE_KEYWORDS[word]
+					break
+		if (keyword is None) and not quoted:
+			for word in sorted(L_MODE_KEYWORDS, key=len, reverse=True):
+				if word_at(plain, i, word):
+					keyword, key = word, L_MODE_KEYWORDS[word]
+					break
+		if keyword is not None:
+			# the ROM puts the spaces around keywords itself
+			while out and out[-1] == "ZX_KEY_SP":
+				out.pop()
+			out.append(key)
+			i += len(keyword)
+			while i < len(plain) and plain[i] == " ":
+				i += 1
+			k_mode = keyword in K_MODE_AFTER
+			continue
+		char = plain[i]
+		out.append(character_key(char))
+		# line numbers and spaces keep K mode, a new statement or line starts it; strings are typed as they are
+		if char == '"':
+			quoted = not quoted
+			k_mode = False
+		elif quoted:
+			pass
+		elif char in ":\n":
+			k_mode = True
+		elif not (char.isdigit() or char == " "):
+			k_mode = False
+		i += 1
+	return out
+
+
+def main():
+	if len(sys.argv) != 3:
+		print("usage: macros.py macros.txt macros.h", file=sys.stderr)
+		return 2
+	source, target = sys.argv[1], sys.argv[2]
+	lines = ["//generated from %s by tools/macros.py, edit that file instead" % source.split("/")[-1], "",
+		"#ifndef MACROS_H_", "#define MACROS_H_", ""]
+	names = []
+	with open(source, encoding="utf-8") as macros:
+		for number, line in enumerate(macros, 1):
+			line = line.rstrip("\r\n")
+			if not line.strip() or line.lstrip().startswith("#"):
+				continue
+			fields = re.match(r"^(\w+)\s+(\w+)\s+(.*)$", line)
+			try:
+				if not fields:
+					raise MacroError("expected NAME profile text")
+				name, profile, text = fields.groups()
+				if profile not in PROFILES:
+					raise MacroError("unknown profile " + profile)
+				keys = compile_text(text, profile)
+				if not keys or len(keys) > 255:
+					raise MacroError("a macro has 1 to 255 keys")
+			except MacroError as error:
+				print("%s:%d: %s" % (source, number, error), file=sys.stderr)
+				return 1
+			lines.append("//" + text.rstrip("\\"))
+			lines.append("#define %s_PROFILE MACRO_PROFILE_%s" % (name, profile.upper()))
+			lines.append("const MACRO_MEM uint8_t %s[]={%s};" % (name, ", ".join(keys)))
+			lines.append("")
+			names.append(name)
+	lines.append("//bytes all the macros take, checked against the EEPROM size")
+	lines.append("#define MACROS_SIZE (%s)" % ("+".join("sizeof(%s)" % name for name in names) or "0"))
+	lines.append("")
+	lines.append("#endif /* MACROS_H_ */")
+	lines.append("")
+	with open(target, "w", newline="\r\n") as header:
+		header.write("\n".join(lines))
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+# HC2000 PS/2 keyboard adapter paste host
+#
+#   paste.py [--port /dev/ttyUSB0] [--profile basic] [--basic] [--line-pause MS] [--output FILE] text|-
+#
+# Sends a text file to a firmware built with PASTE (see src/paste.h), 8N1 at PASTE_BAUD into
+# UNUSED_IO, with XON/XOFF flow control on the adapter's TXD. ASCII goes as it is; with --basic the
+# lines are first tokenized the way macros.py does it, so keywords are typed with their own key and
+# the ones that are not ASCII go as PASTE_RAW and the ZX key code. After every ENTER the adapter
+# pauses --line-pause ms so the ROM can check the line.
+#
+# The adapter sends XOFF with half of its buffer (PASTE_BUF_SIZE, 32 bytes) still free, so the port may
+# send at most 15 more bytes after it. USB adapters that do XON/XOFF in the chip (FTDI, CP210x) stop
+# within a byte or two; with a 16550 port set its transmit FIFO to 8 bytes or less (on Windows the
+# transmit buffer of the port's advanced settings, on Linux "setserial /dev/ttyS0 uart 16450" turns it off).
+#
+# With --output the byte stream is written to a file instead, e.g. to replay it into
+# hal_host_serial_send() of the host build; that needs no pyserial.
+
+import argparse
+import os
+import re
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import macros  # noqa: E402
+
+PASTE_BAUD = 9600
+PASTE_RAW = 0x01
+PASTE_PROFILE = 0x02
+PASTE_PAUSE = 0x03
+
+ZX_CROSSPOINTS = 40
+
+ZX_KEYS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src", "zx_keys.h")
+
+
+def zx_key_codes(path=ZX_KEYS):
+	# evaluates the ZX_KEY_* defines of zx_keys.h
+	defines = {}
+	with open(path, encoding="utf-8") as header:
+		for line in header:
+			match = re.match(r"^#define\s+(ZX_KEY_\w+)\s+([^/]+)", line)
+			if match:
+				defines[match.group(1)] = match.group(2).strip()
+	env = {
+		"ZX_KEY": lambda row, col: (col << 3) | row,
+		"ZX_ONE_KEY": lambda key: key,
+		"ZX_CAP": lambda key: key | 0x40,
+		"ZX_SYM": lambda key: key | 0x80,
+		"ZX_E_MODE": lambda i: ZX_CROSSPOINTS + i,
+	}
+	codes = {}
+	while defines:
+		progress = False
+		for name, expression in list(defines.items()):
+			try:
+				codes[name] = eval(expression, {"__builtins__": {}}, dict(env, **codes))
+			except NameError:
+				continue
+			del defines[name]
+			progress = True
+		if not progress:
+			raise SystemExit("cannot evaluate " + ", ".join(sorted(defines)))
+	return codes
+
+
+def key_value(key, codes):
+	# a macros.py key name or ZX_CAP(...)/ZX_SYM(...) of one
+	return eval(key, {"__builtins__": {}}, dict(codes, ZX_CAP=lambda k: k | 0x40, ZX_SYM=lambda k: k | 0x80))
+
+
+def encode(text, profile, basic, line_pause_ms):
+	codes = zx_key_codes()
+	# what the firmware types for each ASCII character, see PASTE_ASCII
+	ascii_for = {}
+	for char in [chr(c) for c in range(0x20, 0x7F)] + ["\n"]:
+		try:
+			ascii_for.setdefault(key_value(macros.character_key(char), codes), char)
+		except macros.MacroError:
+			pass
+	out = bytearray([PASTE_PROFILE, macros.PROFILES.index(profile)])
+	pause = [PASTE_PAUSE, min(255, line_pause_ms // 10)] if line_pause_ms >= 10 else []
+	for line in text.replace("\r", "").splitlines(keepends=True):
+		if basic:
+			# macros.py escapes are not wanted in a listing
+			keys = macros.compile_text(line.replace("\\", "\\\\").replace("{", "\\{"), "basic")
+		else:
+			keys = [macros.character_key(char) for char in line]
+		for key in keys:
+			value = key_value(key, codes)
+			if value in ascii_for:
+				out += ascii_for[value].encode("ascii")
+			else:
+				out += bytes([PASTE_RAW, value])
+			if value == codes["ZX_KEY_CR"]:
+				out += bytes(pause)
+	return bytes(out)
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--port", default="/dev/ttyUSB0")
+	parser.add_argument("--baud", type=int, default=PASTE_BAUD)
+	parser.add_argument("--profile", choices=macros.PROFILES, default="basic")
+	parser.add_argument("--basic", action="store_true", help="tokenize BASIC keywords")
+	parser.add_argument("--line-pause", type=int, default=200, metavar="MS")
+	parser.add_argument("--output", metavar="FILE")
+	parser.add_argument("text")
+	args = parser.parse_args()
+
+	if args.text == "-":
+		text = sys.stdin.read()
+	else:
+		with open(args.text, encoding="utf-8") as source:
+			text = source.read()
+	try:
+		stream = encode(text, args.profile, args.basic, args.line_pause)
+	except macros.MacroError as error:
+		print("paste.py: %s" % error, file=sys.stderr)
+		return 1
+
+	if args.output:
+		with open(args.output, "wb") as output:
+			output.write(stream)
+		return 0
+
+	import serial
+	with serial.Serial(args.port, args.baud, xonxoff=True) as port:
+		port.write(stream)
+		port.flush()
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+# HC2000 PS/2 keyboard adapter telemetry decoder
+#
+#   telemetry.py [--f-cpu HZ] [--histogram] capture.bin|-
+#
+# Decodes the event records sent out of UNUSED_IO when the firmware is built with TELEMETRY (see
+# src/telemetry.h), e.g. from "stty -F /dev/ttyUSB0 38400 raw; cat /dev/ttyUSB0 > capture.bin".
+# Every record is type, value and a 16 bit TCNT1 time stamp; TCNT1 counts at F_CPU/64, so times
+# are unwrapped on the assumption that no two records are more than one timer period apart
+# (262 ms at 16 MHz). Bytes that do not start a known record are skipped until one does.
+#
+# With --histogram it also prints how long it took from a received byte to the first MT8808
+# switch it caused, and how long each ZX key stayed down.
+
+import argparse
+import sys
+
+TIMER_PRESCALER = 64
+
+RX_BYTE = 0xA1
+FRAME_ERROR = 0xA2
+KEY_DOWN = 0xA3
+KEY_UP = 0xA4
+SWITCH = 0xA5
+RESET = 0xA6
+MACRO = 0xA7
+DROPPED = 0xA8
+
+NAMES = {
+	RX_BYTE: "rx",
+	FRAME_ERROR: "frame error",
+	KEY_DOWN: "key down",
+	KEY_UP: "key up",
+	SWITCH: "switch",
+	RESET: "reset",
+	MACRO: "macro",
+	DROPPED: "dropped",
+}
+
+RECORD_SIZE = 4
+MT8808_ACTION_ON = 0x80
+ZX_CROSSPOINTS = 40
+
+
+def zx_key_name(code):
+	# bit 7 SYM, bit 6 CAPS, then col<<3|row; the codes past the matrix are E mode keys
+	address = code & 0x3F
+	if address >= ZX_CROSSPOINTS:
+		name = "E%d" % (address - ZX_CROSSPOINTS)
+	else:
+		name = "r%d c%d" % (address & 7, address >> 3)
+	if code & 0x40:
+		name = "CAPS+" + name
+	if code & 0x80:
+		name = "SYM+" + name
+	return name
+
+
+def describe(kind, value):
+	if kind == RX_BYTE:
+		return "%02X" % value
+	if kind in (KEY_DOWN, KEY_UP):
+		return zx_key_name(value)
+	if kind == SWITCH:
+		address = value & 0x3F
+		return "r%d c%d %s" % (address & 7, address >> 3, "on" if value & MT8808_ACTION_ON else "off")
+	if kind == MACRO:
+		return ("stop", "start", "record start", "record stop")[value & 3]
+	if kind in (FRAME_ERROR, DROPPED):
+		return "%d" % value
+	return ""
+
+
+def records(data):
+	# yields (type, value, TCNT1); skips to the next known type when out of step
+	i = 0
+	while i + RECORD_SIZE <= len(data):
+		if data[i] not in NAMES:
+			i += 1
+			continue
+		yield data[i], data[i + 1], data[i + 2] | (data[i + 3] << 8)
+		i += RECORD_SIZE
+
+
+def histogram(title, samples_us):
+	print()
+	print("%s, %d samples" % (title, len(samples_us)))
+	if not samples_us:
+		return
+	# powers of two buckets from 16 us up
+	buckets = {}
+	for sample in samples_us:
+		limit = 16
+		while sample >= limit:
+			limit *= 2
+		buckets[limit] = buckets.get(limit, 0) + 1
+	widest = max(buckets.values())
+	for limit in sorted(buckets):
+		count = buckets[limit]
+		print("  < %8d us %6d %s" % (limit, count, "#" * max(1, count * 40 // widest)))
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--f-cpu", type=int, default=16000000)
+	parser.add_argument("--histogram", action="store_true")
+	parser.add_argument("capture")
+	args = parser.parse_args()
+
+	if args.capture == "-":
+		data = sys.stdin.buffer.read()
+	else:
+		with open(args.capture, "rb") as capture:
+			data = capture.read()
+
+	tick_us = TIMER_PRESCALER * 1e6 / args.f_cpu
+	now = 0
+	previous = None
+	rx_time = None
+	key_down = {}
+	latencies = []
+	hold_times = []
+
+	for kind, value, stamp in records(data):
+		if previous is not None:
+			now += (stamp - previous) & 0xFFFF
+		previous = stamp
+		time_us = now * tick_us
+		print("%12.3f ms  %-12s %s" % (time_us / 1000, NAMES[kind], describe(kind, value)))
+
+		if kind == RX_BYTE:
+			rx_time = time_us
+		elif kind == SWITCH and rx_time is not None:
+			latencies.append(time_us - rx_time)
+			rx_time = None
+		elif kind == KEY_DOWN:
+			key_down[value] = time_us
+		elif kind == KEY_UP and value in key_down:
+			hold_times.append(time_us - key_down.pop(value))
+		elif kind == RESET:
+			key_down.clear()
+
+	if args.histogram:
+		histogram("received byte to first switch", latencies)
+		histogram("key down to key up", hold_times)
+		if key_down:
+			print()
+			print("still down: " + ", ".join(zx_key_name(code) for code in sorted(key_down)))
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())